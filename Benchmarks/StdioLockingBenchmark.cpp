@@ -0,0 +1,88 @@
+// Compares the locked and unlocked stdio paths of CFileInStream/CFileOutStream on lots of small
+// values. Streams are unbuffered, so every WriteU32/ReadU32 is one fwrite/fread call.
+// Usage: StdioLockingBenchmark [scratch file] [value count]
+#include <Common/CTimer.h>
+#include <Common/FileUtil.h>
+#include <Common/Log.h>
+#include <Common/FileIO/CFileInStream.h>
+#include <Common/FileIO/CFileOutStream.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/format.h>
+
+namespace
+{
+
+constexpr uint32_t kDefaultNumValues = 8000000;
+constexpr int kNumRuns = 3;
+
+double TimeWrite(const TString& rkFile, uint32_t NumValues, bool Unlocked)
+{
+    CTimer Timer;
+    Timer.Start();
+    {
+        CFileOutStream Out(rkFile, std::endian::big, 0, EFileSyncPolicy::None, Unlocked);
+
+        for (uint32_t ValueIdx = 0; ValueIdx < NumValues; ValueIdx++)
+            Out.WriteU32(ValueIdx);
+
+        if (!Out.Close())
+            return -1.0;
+    }
+    return Timer.Stop();
+}
+
+double TimeRead(const TString& rkFile, uint32_t NumValues, bool Unlocked)
+{
+    CTimer Timer;
+    Timer.Start();
+
+    CFileInStream In(rkFile, std::endian::big, 0, Unlocked);
+    uint64_t Sum = 0;
+
+    for (uint32_t ValueIdx = 0; ValueIdx < NumValues; ValueIdx++)
+        Sum += In.ReadU32();
+
+    const double Time = Timer.Stop();
+    return Sum == uint64_t(NumValues) * (NumValues - 1) / 2 ? Time : -1.0;
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    const TString File = (argc > 1 ? argv[1] : "StdioLockingBenchmark.bin");
+    const uint32_t NumValues = (argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 0)) : kDefaultNumValues);
+    NLog::InitLog("StdioLockingBenchmark.log");
+
+    fmt::print("{} ReadU32/WriteU32 calls per run, best of {}\n", NumValues, kNumRuns);
+
+    for (const bool Unlocked : {false, true})
+    {
+        double BestWrite = 0.0;
+        double BestRead = 0.0;
+
+        for (int Run = 0; Run < kNumRuns; Run++)
+        {
+            const double WriteTime = TimeWrite(File, NumValues, Unlocked);
+            const double ReadTime = TimeRead(File, NumValues, Unlocked);
+
+            if (WriteTime < 0.0 || ReadTime < 0.0)
+            {
+                fmt::print(stderr, "Failed to write or read back {}\n", File);
+                FileUtil::DeleteFile(File);
+                return 1;
+            }
+
+            BestWrite = (Run == 0 ? WriteTime : std::min(BestWrite, WriteTime));
+            BestRead = (Run == 0 ? ReadTime : std::min(BestRead, ReadTime));
+        }
+
+        fmt::print("{:>8}: write {:7.1f} ms, read {:7.1f} ms\n", Unlocked ? "unlocked" : "locked",
+                   BestWrite * 1000.0, BestRead * 1000.0);
+    }
+
+    FileUtil::DeleteFile(File);
+    return 0;
+}
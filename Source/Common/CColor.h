@@ -15,6 +15,8 @@ public:
     float B = 0.0f;
     float A = 0.0f;
 
+    using BulkSerialComponent = float;
+
     constexpr CColor() = default;
     explicit CColor(IInputStream& rInput, bool Integral = false);
     constexpr CColor(float RGBA) : R{RGBA}, G{RGBA}, B{RGBA}, A{RGBA} {}
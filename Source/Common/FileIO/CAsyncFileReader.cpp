@@ -0,0 +1,522 @@
+#include "CAsyncFileReader.h"
+
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define AXIO_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+namespace
+{
+
+// Largest amount handed to the OS in one read; larger requests are split up
+constexpr size_t kMaxReadSize = 0x7FFFF000;
+
+} // anonymous namespace
+
+#ifdef AXIO_HAS_IO_URING
+// Raw io_uring instance, set up with direct syscalls so there's no dependency on liburing
+struct CAsyncFileReader::SRing
+{
+    int RingDesc = -1;
+    void *pSQRing = nullptr;
+    size_t SQRingSize = 0;
+    void *pCQRing = nullptr;
+    size_t CQRingSize = 0;
+    io_uring_sqe *pSQEs = nullptr;
+    size_t SQEsSize = 0;
+
+    uint32_t *pSQHead = nullptr;
+    uint32_t *pSQTail = nullptr;
+    uint32_t *pSQArray = nullptr;
+    uint32_t SQMask = 0;
+    uint32_t NumSQEntries = 0;
+
+    uint32_t *pCQHead = nullptr;
+    uint32_t *pCQTail = nullptr;
+    io_uring_cqe *pCQEs = nullptr;
+    uint32_t CQMask = 0;
+
+    bool Init(uint32_t NumEntries)
+    {
+        io_uring_params Params{};
+        RingDesc = static_cast<int>(syscall(__NR_io_uring_setup, NumEntries, &Params));
+
+        // Commonly blocked by seccomp policies or disabled by sysctl; the caller falls back to threads
+        if (RingDesc < 0)
+            return false;
+
+        SQRingSize = Params.sq_off.array + Params.sq_entries * sizeof(uint32_t);
+        CQRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+
+        if (Params.features & IORING_FEAT_SINGLE_MMAP)
+            SQRingSize = CQRingSize = std::max(SQRingSize, CQRingSize);
+
+        pSQRing = mmap(nullptr, SQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingDesc, IORING_OFF_SQ_RING);
+
+        if (pSQRing == MAP_FAILED)
+        {
+            pSQRing = nullptr;
+            return false;
+        }
+
+        if (Params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            pCQRing = pSQRing;
+        }
+        else
+        {
+            pCQRing = mmap(nullptr, CQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingDesc, IORING_OFF_CQ_RING);
+
+            if (pCQRing == MAP_FAILED)
+            {
+                pCQRing = nullptr;
+                return false;
+            }
+        }
+
+        SQEsSize = Params.sq_entries * sizeof(io_uring_sqe);
+        void *pSQEMapping = mmap(nullptr, SQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingDesc, IORING_OFF_SQES);
+
+        if (pSQEMapping == MAP_FAILED)
+            return false;
+
+        pSQEs = static_cast<io_uring_sqe*>(pSQEMapping);
+
+        auto *pSQBytes = static_cast<uint8_t*>(pSQRing);
+        pSQHead = reinterpret_cast<uint32_t*>(pSQBytes + Params.sq_off.head);
+        pSQTail = reinterpret_cast<uint32_t*>(pSQBytes + Params.sq_off.tail);
+        pSQArray = reinterpret_cast<uint32_t*>(pSQBytes + Params.sq_off.array);
+        SQMask = *reinterpret_cast<uint32_t*>(pSQBytes + Params.sq_off.ring_mask);
+        NumSQEntries = Params.sq_entries;
+
+        auto *pCQBytes = static_cast<uint8_t*>(pCQRing);
+        pCQHead = reinterpret_cast<uint32_t*>(pCQBytes + Params.cq_off.head);
+        pCQTail = reinterpret_cast<uint32_t*>(pCQBytes + Params.cq_off.tail);
+        pCQEs = reinterpret_cast<io_uring_cqe*>(pCQBytes + Params.cq_off.cqes);
+        CQMask = *reinterpret_cast<uint32_t*>(pCQBytes + Params.cq_off.ring_mask);
+        return true;
+    }
+
+    ~SRing()
+    {
+        if (pSQEs)
+            munmap(pSQEs, SQEsSize);
+        if (pCQRing && pCQRing != pSQRing)
+            munmap(pCQRing, CQRingSize);
+        if (pSQRing)
+            munmap(pSQRing, SQRingSize);
+        if (RingDesc >= 0)
+            close(RingDesc);
+    }
+};
+#else
+struct CAsyncFileReader::SRing
+{
+};
+#endif
+
+// Worker threads for the fallback path. They sleep between batches and every worker takes part in
+// every batch, so a batch is over once all of them have reported back.
+struct CAsyncFileReader::SThreadPool
+{
+    std::vector<std::thread> Workers;
+    std::mutex Mutex;
+    std::condition_variable WakeCondition;
+    std::condition_variable DoneCondition;
+    std::function<void()> Job;
+    uint64_t BatchID = 0;
+    size_t NumBusy = 0;
+    bool Quit = false;
+
+    explicit SThreadPool(size_t NumWorkers)
+    {
+        Workers.reserve(NumWorkers);
+
+        for (size_t WorkerIdx = 0; WorkerIdx < NumWorkers; WorkerIdx++)
+            Workers.emplace_back([this]() { WorkerMain(); });
+    }
+
+    ~SThreadPool()
+    {
+        {
+            std::lock_guard Lock(Mutex);
+            Quit = true;
+        }
+        WakeCondition.notify_all();
+
+        for (std::thread& rWorker : Workers)
+            rWorker.join();
+    }
+
+    /** Runs Func on every worker and on the calling thread, and waits for all of them to return */
+    void Run(std::function<void()> Func)
+    {
+        {
+            std::lock_guard Lock(Mutex);
+            Job = std::move(Func);
+            BatchID++;
+            NumBusy = Workers.size();
+        }
+        WakeCondition.notify_all();
+
+        Job();
+
+        std::unique_lock Lock(Mutex);
+        DoneCondition.wait(Lock, [this]() { return NumBusy == 0; });
+        Job = nullptr;
+    }
+
+    void WorkerMain()
+    {
+        uint64_t LastBatchID = 0;
+        std::unique_lock Lock(Mutex);
+
+        while (true)
+        {
+            WakeCondition.wait(Lock, [&]() { return Quit || BatchID != LastBatchID; });
+
+            if (Quit)
+                return;
+
+            LastBatchID = BatchID;
+            Lock.unlock();
+            Job();
+            Lock.lock();
+
+            if (--NumBusy == 0)
+                DoneCondition.notify_one();
+        }
+    }
+};
+
+CAsyncFileReader::CAsyncFileReader(uint32_t QueueDepth /*= skDefaultQueueDepth*/)
+    : mQueueDepth(std::max(QueueDepth, 1u))
+{
+#ifdef AXIO_HAS_IO_URING
+    auto pRing = std::make_unique<SRing>();
+
+    if (pRing->Init(mQueueDepth))
+        mpRing = std::move(pRing);
+#endif
+}
+
+CAsyncFileReader::~CAsyncFileReader()
+{
+    CloseFiles();
+}
+
+uint32_t CAsyncFileReader::AddFile(const TString& rkFile)
+{
+    SFile File;
+    File.Name = rkFile;
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(ToWChar(rkFile), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return skInvalidFile;
+
+    LARGE_INTEGER FileSize;
+
+    if (!GetFileSizeEx(hFile, &FileSize))
+    {
+        NLog::Error("{}: Unable to determine file size", rkFile);
+        CloseHandle(hFile);
+        return skInvalidFile;
+    }
+
+    File.hFile = hFile;
+    File.Size = static_cast<uint64_t>(FileSize.QuadPart);
+#else
+    const int FileDesc = open(rkFile.CString(), O_RDONLY | O_CLOEXEC);
+
+    if (FileDesc == -1)
+        return skInvalidFile;
+
+    struct stat FileStat;
+
+    if (fstat(FileDesc, &FileStat) != 0)
+    {
+        NLog::Error("{}: Unable to determine file size", rkFile);
+        close(FileDesc);
+        return skInvalidFile;
+    }
+
+    File.FileDesc = FileDesc;
+    File.Size = static_cast<uint64_t>(FileStat.st_size);
+#endif
+
+    mFiles.push_back(std::move(File));
+    return static_cast<uint32_t>(mFiles.size() - 1);
+}
+
+void CAsyncFileReader::CloseFiles()
+{
+    for (const SFile& rkFile : mFiles)
+    {
+#ifdef _WIN32
+        CloseHandle(rkFile.hFile);
+#else
+        close(rkFile.FileDesc);
+#endif
+    }
+
+    mFiles.clear();
+}
+
+uint32_t CAsyncFileReader::NumFiles() const
+{
+    return static_cast<uint32_t>(mFiles.size());
+}
+
+uint64_t CAsyncFileReader::FileSize(uint32_t FileIdx) const
+{
+    return FileIdx < mFiles.size() ? mFiles[FileIdx].Size : 0;
+}
+
+bool CAsyncFileReader::Read(std::span<SReadRequest> Requests)
+{
+    // Issue reads in file order so neighbouring requests reach the disk together
+    std::vector<uint32_t> Order;
+    Order.reserve(Requests.size());
+
+    for (uint32_t ReqIdx = 0; ReqIdx < Requests.size(); ReqIdx++)
+    {
+        SReadRequest& rRequest = Requests[ReqIdx];
+        rRequest.BytesRead = 0;
+        rRequest.Success = rRequest.Dst.empty();
+
+        if (rRequest.FileIdx >= mFiles.size())
+            NLog::Error("Async read requested from invalid file index {}", rRequest.FileIdx);
+        else if (!rRequest.Dst.empty())
+            Order.push_back(ReqIdx);
+    }
+
+    std::sort(Order.begin(), Order.end(), [Requests](uint32_t Left, uint32_t Right) {
+        const SReadRequest& rkLeft = Requests[Left];
+        const SReadRequest& rkRight = Requests[Right];
+        return rkLeft.FileIdx != rkRight.FileIdx ? rkLeft.FileIdx < rkRight.FileIdx : rkLeft.Offset < rkRight.Offset;
+    });
+
+    if (!Order.empty())
+    {
+        if (!mpRing || !ReadWithRing(Requests, Order))
+            ReadWithThreads(Requests, Order);
+    }
+
+    return std::all_of(Requests.begin(), Requests.end(), [](const SReadRequest& rkRequest) {
+        return rkRequest.Success;
+    });
+}
+
+bool CAsyncFileReader::IsUsingIORing() const
+{
+    return mpRing != nullptr;
+}
+
+// ************ PRIVATE ************
+bool CAsyncFileReader::ReadWithRing(std::span<SReadRequest> Requests, const std::vector<uint32_t>& rkOrder)
+{
+#ifdef AXIO_HAS_IO_URING
+    SRing& rRing = *mpRing;
+    std::vector<iovec> IOVecs(Requests.size());
+    std::vector<uint32_t> Resubmits;    // Requests that came back short or were interrupted
+    size_t NextOrderIdx = 0;
+    uint32_t NumInFlight = 0;
+    uint32_t NumUnsubmitted = 0;
+
+    auto ReapCompletions = [&]() {
+        uint32_t Head = *rRing.pCQHead;
+        const uint32_t CQTail = std::atomic_ref<uint32_t>(*rRing.pCQTail).load(std::memory_order_acquire);
+
+        for (; Head != CQTail; Head++)
+        {
+            const io_uring_cqe& rkCQE = rRing.pCQEs[Head & rRing.CQMask];
+            SReadRequest& rRequest = Requests[static_cast<uint32_t>(rkCQE.user_data)];
+            NumInFlight--;
+
+            if (rkCQE.res > 0)
+            {
+                rRequest.BytesRead += static_cast<size_t>(rkCQE.res);
+
+                if (rRequest.BytesRead == rRequest.Dst.size())
+                    rRequest.Success = true;
+                else
+                    Resubmits.push_back(static_cast<uint32_t>(rkCQE.user_data));
+            }
+            else if (rkCQE.res == -EINTR || rkCQE.res == -EAGAIN)
+            {
+                Resubmits.push_back(static_cast<uint32_t>(rkCQE.user_data));
+            }
+            // Zero means end of file; anything else is a read error. Either way the request is done.
+        }
+
+        std::atomic_ref<uint32_t>(*rRing.pCQHead).store(Head, std::memory_order_release);
+    };
+
+    while (NextOrderIdx < rkOrder.size() || !Resubmits.empty() || NumInFlight > 0)
+    {
+        // Top up the submission queue
+        uint32_t Tail = *rRing.pSQTail;
+
+        while (NumInFlight < rRing.NumSQEntries && (!Resubmits.empty() || NextOrderIdx < rkOrder.size()))
+        {
+            uint32_t ReqIdx;
+
+            if (!Resubmits.empty())
+            {
+                ReqIdx = Resubmits.back();
+                Resubmits.pop_back();
+            }
+            else
+            {
+                ReqIdx = rkOrder[NextOrderIdx++];
+            }
+
+            const SReadRequest& rkRequest = Requests[ReqIdx];
+            IOVecs[ReqIdx].iov_base = rkRequest.Dst.data() + rkRequest.BytesRead;
+            IOVecs[ReqIdx].iov_len = std::min(rkRequest.Dst.size() - rkRequest.BytesRead, kMaxReadSize);
+
+            const uint32_t Slot = Tail & rRing.SQMask;
+            io_uring_sqe& rSQE = rRing.pSQEs[Slot];
+            std::memset(&rSQE, 0, sizeof(rSQE));
+            rSQE.opcode = IORING_OP_READV;
+            rSQE.fd = mFiles[rkRequest.FileIdx].FileDesc;
+            rSQE.addr = reinterpret_cast<uintptr_t>(&IOVecs[ReqIdx]);
+            rSQE.len = 1;
+            rSQE.off = rkRequest.Offset + rkRequest.BytesRead;
+            rSQE.user_data = ReqIdx;
+            rRing.pSQArray[Slot] = Slot;
+
+            Tail++;
+            NumInFlight++;
+            NumUnsubmitted++;
+        }
+
+        std::atomic_ref<uint32_t>(*rRing.pSQTail).store(Tail, std::memory_order_release);
+
+        const long Result = syscall(__NR_io_uring_enter, rRing.RingDesc, NumUnsubmitted, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+        if (Result >= 0)
+        {
+            NumUnsubmitted -= static_cast<uint32_t>(Result);
+        }
+        else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            // Shouldn't happen with a working ring. Give it up and let the thread pool redo whatever
+            // hasn't finished, but only once the kernel is done with every read it was handed, since
+            // those still write into the callers' buffers. Entries it never picked up won't be
+            // submitted, because nothing is submitted from here on.
+            NLog::Error("io_uring_enter failed ({}); falling back to threaded reads", std::strerror(errno));
+            NumInFlight -= NumUnsubmitted;
+
+            while (NumInFlight > 0)
+            {
+                // If the ring can't even wait any more, poll; the sleep still lets completions post
+                if (syscall(__NR_io_uring_enter, rRing.RingDesc, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+                ReapCompletions();
+            }
+
+            mpRing.reset();
+            return false;
+        }
+
+        ReapCompletions();
+    }
+
+    return true;
+#else
+    (void) Requests;
+    (void) rkOrder;
+    return false;
+#endif
+}
+
+void CAsyncFileReader::ReadWithThreads(std::span<SReadRequest> Requests, const std::vector<uint32_t>& rkOrder)
+{
+    std::atomic<size_t> NextOrderIdx{0};
+
+    auto Worker = [&]() {
+        for (size_t OrderIdx = NextOrderIdx++; OrderIdx < rkOrder.size(); OrderIdx = NextOrderIdx++)
+        {
+            SReadRequest& rRequest = Requests[rkOrder[OrderIdx]];
+
+            if (!rRequest.Success)
+                ReadOne(rRequest);
+        }
+    };
+
+    // A single request isn't worth waking the pool for
+    if (rkOrder.size() == 1)
+    {
+        Worker();
+        return;
+    }
+
+    // One blocking read per thread, so the thread count is what sets the queue depth. The calling
+    // thread makes up the last one.
+    if (!mpThreadPool)
+        mpThreadPool = std::make_unique<SThreadPool>(mQueueDepth - 1);
+
+    mpThreadPool->Run(Worker);
+}
+
+void CAsyncFileReader::ReadOne(SReadRequest& rRequest) const
+{
+    const SFile& rkFile = mFiles[rRequest.FileIdx];
+
+    while (rRequest.BytesRead < rRequest.Dst.size())
+    {
+        const size_t NumToRead = std::min(rRequest.Dst.size() - rRequest.BytesRead, kMaxReadSize);
+        const uint64_t Offset = rRequest.Offset + rRequest.BytesRead;
+
+#ifdef _WIN32
+        OVERLAPPED Overlapped{};
+        Overlapped.Offset = static_cast<DWORD>(Offset);
+        Overlapped.OffsetHigh = static_cast<DWORD>(Offset >> 32);
+        DWORD NumRead = 0;
+
+        if (!ReadFile(rkFile.hFile, rRequest.Dst.data() + rRequest.BytesRead, static_cast<DWORD>(NumToRead), &NumRead, &Overlapped) || NumRead == 0)
+            return;
+#else
+        const ssize_t NumRead = pread(rkFile.FileDesc, rRequest.Dst.data() + rRequest.BytesRead, NumToRead, static_cast<off_t>(Offset));
+
+        if (NumRead < 0 && errno == EINTR)
+            continue;
+
+        if (NumRead <= 0)
+            return;
+#endif
+
+        rRequest.BytesRead += static_cast<size_t>(NumRead);
+    }
+
+    rRequest.Success = true;
+}
@@ -0,0 +1,82 @@
+#ifndef AXIO_CASYNCFILEREADER_H
+#define AXIO_CASYNCFILEREADER_H
+
+#include "Common/TString.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Performs batches of positioned reads against a set of files, keeping many of them in flight at
+// once instead of issuing them one by one through a stream. Meant for pulling lots of small,
+// scattered resources out of large archives. On Linux the reads go through io_uring when the
+// kernel allows it; everywhere else (or if setup fails) a pool of threads issues positioned reads.
+// Only one batch may be in progress per reader at a time.
+class CAsyncFileReader
+{
+public:
+    struct SReadRequest
+    {
+        uint32_t FileIdx = 0;       // Index returned by AddFile()
+        uint64_t Offset = 0;
+        std::span<uint8_t> Dst;
+
+        // Filled in when the batch completes
+        size_t BytesRead = 0;
+        bool Success = false;       // Set if the whole of Dst was filled
+    };
+
+    static constexpr uint32_t skInvalidFile = UINT32_MAX;
+    static constexpr uint32_t skDefaultQueueDepth = 32;
+
+private:
+    struct SFile
+    {
+        TString Name;
+        uint64_t Size = 0;
+#ifdef _WIN32
+        void *hFile = nullptr;
+#else
+        int FileDesc = -1;
+#endif
+    };
+
+    struct SRing;
+    struct SThreadPool;
+
+    std::vector<SFile> mFiles;
+    std::unique_ptr<SRing> mpRing;
+    std::unique_ptr<SThreadPool> mpThreadPool;     // Started by the first batch that needs it
+    uint32_t mQueueDepth;
+
+public:
+    explicit CAsyncFileReader(uint32_t QueueDepth = skDefaultQueueDepth);
+    ~CAsyncFileReader();
+
+    CAsyncFileReader(const CAsyncFileReader&) = delete;
+    CAsyncFileReader& operator=(const CAsyncFileReader&) = delete;
+
+    /** Opens a file for reading and returns its index, or skInvalidFile if it couldn't be opened */
+    uint32_t AddFile(const TString& rkFile);
+    void CloseFiles();
+    uint32_t NumFiles() const;
+    uint64_t FileSize(uint32_t FileIdx) const;
+
+    /**
+     * Performs every request in the list and waits for all of them to finish. Requests are issued
+     * in file/offset order regardless of the order they're listed in. Returns true if every
+     * request was read in full; reads that run past the end of a file stop short and fail.
+     */
+    bool Read(std::span<SReadRequest> Requests);
+
+    /** Whether batches are going through io_uring rather than the thread pool */
+    bool IsUsingIORing() const;
+
+private:
+    bool ReadWithRing(std::span<SReadRequest> Requests, const std::vector<uint32_t>& rkOrder);
+    void ReadWithThreads(std::span<SReadRequest> Requests, const std::vector<uint32_t>& rkOrder);
+    void ReadOne(SReadRequest& rRequest) const;
+};
+
+#endif // AXIO_CASYNCFILEREADER_H
@@ -2,67 +2,167 @@
 
 #include "IInputStream.h"
 
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+uint64_t ExtractBits(uint64_t& rPool, uint32_t& rBitsRemaining, uint32_t NumBits, bool ExtendSignBit)
+{
+    const uint64_t Mask = (uint64_t{1} << NumBits) - 1;
+    uint64_t Out = rPool & Mask;
+    rPool >>= NumBits;
+    rBitsRemaining -= NumBits;
+
+    if (ExtendSignBit && (Out >> (NumBits - 1)) != 0)
+        Out |= ~Mask;
+
+    return Out;
+}
+
+} // anonymous namespace
+
 CBitStreamInWrapper::CBitStreamInWrapper(IInputStream *pStream, EChunkSize ChunkSize /*= e32Bit*/)
     : mpSourceStream(pStream)
     , mChunkSize(ChunkSize)
+    , mSourceEndianness(pStream->GetEndianness())
 {
 }
 
+CBitStreamInWrapper::~CBitStreamInWrapper()
+{
+    SyncSource();
+}
+
 void CBitStreamInWrapper::SetChunkSize(EChunkSize Size)
 {
+    // Chunks that were already loaded were split at the old size, so reload them
+    SyncSource();
     mChunkSize = Size;
 }
 
 int CBitStreamInWrapper::ReadBits(uint32_t NumBits, bool ExtendSignBit /*= true*/)
 {
-    uint32_t BitsRemaining = NumBits;
-    uint32_t Out = 0;
-    uint32_t Shift = 0;
+    if (NumBits == 0)
+        return 0;
+
+    if (mBitsRemaining < NumBits)
+        ReplenishPool();
+
+    return static_cast<int>(ExtractBits(mBitPool, mBitsRemaining, NumBits, ExtendSignBit));
+}
+
+bool CBitStreamInWrapper::ReadBit()
+{
+    return (ReadBits(1, false) != 0);
+}
 
-    while (BitsRemaining > 0)
+void CBitStreamInWrapper::ReadBitsBatch(uint32_t Count, uint32_t NumBits, int32_t *pOut, bool ExtendSignBit /*= true*/)
+{
+    if (NumBits == 0)
     {
-        if (mBitsRemaining < BitsRemaining)
-        {
-            BitsRemaining -= mBitsRemaining;
-            Out |= (mBitPool << Shift);
-            Shift += mBitsRemaining;
-            ReplenishPool();
-        }
+        std::fill_n(pOut, Count, 0);
+        return;
+    }
 
-        else
+    // Work on local copies so the pool stays in registers for the length of the loop
+    uint64_t Pool = mBitPool;
+    uint32_t BitsRemaining = mBitsRemaining;
+
+    for (uint32_t Idx = 0; Idx < Count; Idx++)
+    {
+        if (BitsRemaining < NumBits)
         {
-            const uint32_t Mask = (1U << BitsRemaining) - 1;
-            Out |= (mBitPool & Mask) << Shift;
-            mBitPool >>= BitsRemaining;
-            mBitsRemaining -= BitsRemaining;
-            BitsRemaining = 0;
+            mBitPool = Pool;
+            mBitsRemaining = BitsRemaining;
+            ReplenishPool();
+            Pool = mBitPool;
+            BitsRemaining = mBitsRemaining;
         }
-    }
 
-    if (ExtendSignBit)
-    {
-        const bool Sign = ((Out >> (NumBits - 1) & 0x1) == 1);
-        if (Sign)
-            Out |= (UINT32_MAX << NumBits);
+        pOut[Idx] = static_cast<int32_t>(ExtractBits(Pool, BitsRemaining, NumBits, ExtendSignBit));
     }
 
-    return static_cast<int>(Out);
+    mBitPool = Pool;
+    mBitsRemaining = BitsRemaining;
 }
 
-bool CBitStreamInWrapper::ReadBit()
+void CBitStreamInWrapper::SyncSource()
 {
-    return (ReadBits(1, false) != 0);
+    // Whole chunks in the pool haven't been touched yet; only a partially read chunk stays
+    const uint32_t NumUntouchedChunks = mBitsRemaining / mChunkSize;
+    const uint32_t NumRealChunks = NumUntouchedChunks - std::min(NumUntouchedChunks, mNumPaddingChunks);
+    const uint32_t NumUnusedBytes = (mBufferFill - mBufferPos) + NumRealChunks * (mChunkSize / 8);
+
+    if (NumUnusedBytes > 0)
+        mpSourceStream->Skip(-static_cast<int64_t>(NumUnusedBytes));
+
+    mBitsRemaining %= mChunkSize;
+    mBitPool &= (uint64_t{1} << mBitsRemaining) - 1;
+    mNumPaddingChunks = 0;
+    mBufferPos = 0;
+    mBufferFill = 0;
 }
 
 // ************ PRIVATE ************
 void CBitStreamInWrapper::ReplenishPool()
 {
-    if (mChunkSize == k8Bit)
-        mBitPool = mpSourceStream->ReadU8();
-    else if (mChunkSize == k16Bit)
-        mBitPool = mpSourceStream->ReadU16();
-    else if (mChunkSize == k32Bit)
-        mBitPool = mpSourceStream->ReadU32();
-
-    mBitsRemaining = mChunkSize;
+    const uint32_t ChunkBytes = mChunkSize / 8;
+
+    // Load as many whole chunks as fit in the pool
+    while (mBitsRemaining + mChunkSize <= 64)
+    {
+        if (mBufferFill - mBufferPos < ChunkBytes)
+            FillBuffer();
+
+        uint64_t Chunk = 0;
+
+        if (mBufferFill - mBufferPos < ChunkBytes)
+        {
+            // Past the end of the source, so pad with zeroes
+            mNumPaddingChunks++;
+        }
+        else
+        {
+            const uint8_t *pkChunk = &mBuffer[mBufferPos];
+            mBufferPos += ChunkBytes;
+
+            if (mSourceEndianness == std::endian::little)
+            {
+                for (uint32_t ByteIdx = 0; ByteIdx < ChunkBytes; ByteIdx++)
+                    Chunk |= uint64_t{pkChunk[ByteIdx]} << (ByteIdx * 8);
+            }
+            else
+            {
+                for (uint32_t ByteIdx = 0; ByteIdx < ChunkBytes; ByteIdx++)
+                    Chunk = (Chunk << 8) | pkChunk[ByteIdx];
+            }
+        }
+
+        mBitPool |= Chunk << mBitsRemaining;
+        mBitsRemaining += mChunkSize;
+    }
+}
+
+void CBitStreamInWrapper::FillBuffer()
+{
+    const uint32_t NumLeftover = mBufferFill - mBufferPos;
+    std::memmove(mBuffer.data(), mBuffer.data() + mBufferPos, NumLeftover);
+    mBufferPos = 0;
+    mBufferFill = NumLeftover;
+
+    if (!mpSourceStream->IsValid())
+        return;
+
+    // Don't read past the end of the source; not every stream checks for that itself
+    const uint64_t Start = mpSourceStream->Tell();
+    const uint64_t SourceRemaining = mpSourceStream->Size() - std::min(Start, mpSourceStream->Size());
+    const auto NumToRead = static_cast<size_t>(std::min<uint64_t>(skBufferSize - NumLeftover, SourceRemaining));
+
+    if (NumToRead > 0)
+    {
+        mpSourceStream->ReadBytes(mBuffer.data() + NumLeftover, NumToRead);
+        mBufferFill += static_cast<uint32_t>(mpSourceStream->Tell() - Start);
+    }
 }
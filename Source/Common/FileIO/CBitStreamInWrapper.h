@@ -1,10 +1,16 @@
 #ifndef AXIO_CBITSTREAMINWRAPPER_H
 #define AXIO_CBITSTREAMINWRAPPER_H
 
+#include <array>
+#include <bit>
 #include <cstdint>
 
 class IInputStream;
 
+// Reads bit-packed data from a stream. Bits are consumed LSB-first from chunks of 8, 16 or 32 bits,
+// each read in the stream's endianness. Source data is pulled in through a small byte buffer and
+// kept in a 64-bit pool, so the source stream is read ahead of the bits that have been consumed;
+// call SyncSource() (or destroy the wrapper) before reading from the source directly again.
 class CBitStreamInWrapper
 {
 public:
@@ -14,19 +20,42 @@ public:
     };
 
 private:
+    static constexpr uint32_t skBufferSize = 0x100;
+
     IInputStream *mpSourceStream = nullptr;
     EChunkSize mChunkSize{k32Bit};
-    uint32_t mBitPool = 0;
+    std::endian mSourceEndianness = std::endian::little;
+    uint64_t mBitPool = 0;
     uint32_t mBitsRemaining = 0;
+    uint32_t mNumPaddingChunks = 0;     // Zero chunks added to the pool past the end of the source
+
+    std::array<uint8_t, skBufferSize> mBuffer{};
+    uint32_t mBufferPos = 0;
+    uint32_t mBufferFill = 0;
 
 public:
     explicit CBitStreamInWrapper(IInputStream *pStream, EChunkSize ChunkSize = k32Bit);
+    ~CBitStreamInWrapper();
+
+    CBitStreamInWrapper(const CBitStreamInWrapper&) = delete;
+    CBitStreamInWrapper& operator=(const CBitStreamInWrapper&) = delete;
+
     void SetChunkSize(EChunkSize Size);
     int ReadBits(uint32_t NumBits, bool ExtendSignBit = true);
     bool ReadBit();
 
+    /** Reads Count consecutive fields of NumBits bits each; equivalent to calling ReadBits() Count times */
+    void ReadBitsBatch(uint32_t Count, uint32_t NumBits, int32_t *pOut, bool ExtendSignBit = true);
+
+    /**
+     * Moves the source stream back to just past the last chunk that bits have been read from,
+     * discarding any data that was read ahead.
+     */
+    void SyncSource();
+
 private:
     void ReplenishPool();
+    void FillBuffer();
 };
 
 #endif // AXIO_CBITSTREAMINWRAPPER_H
@@ -0,0 +1,122 @@
+#include "CBitStreamOutWrapper.h"
+
+#include "IOutputStream.h"
+
+CBitStreamOutWrapper::CBitStreamOutWrapper(IOutputStream *pStream, EChunkSize ChunkSize /*= k32Bit*/)
+    : mpDestStream(pStream)
+    , mChunkSize(ChunkSize)
+    , mDestEndianness(pStream->GetEndianness())
+{
+}
+
+CBitStreamOutWrapper::~CBitStreamOutWrapper()
+{
+    Flush();
+}
+
+void CBitStreamOutWrapper::SetChunkSize(EChunkSize Size)
+{
+    Flush();
+    mChunkSize = Size;
+}
+
+void CBitStreamOutWrapper::WriteBits(uint32_t Value, uint32_t NumBits)
+{
+    if (NumBits == 0)
+        return;
+
+    // The pool always has fewer than 32 bits pending, so any value fits without splitting it
+    const uint64_t Mask = (uint64_t{1} << NumBits) - 1;
+    mBitPool |= (Value & Mask) << mBitCount;
+    mBitCount += NumBits;
+
+    if (mBitCount >= 32)
+        DrainPool();
+}
+
+void CBitStreamOutWrapper::WriteBit(bool Bit)
+{
+    WriteBits(Bit ? 1 : 0, 1);
+}
+
+void CBitStreamOutWrapper::WriteBitsBatch(uint32_t Count, uint32_t NumBits, const int32_t *pkValues)
+{
+    if (NumBits == 0)
+        return;
+
+    // Work on local copies so the pool stays in registers for the length of the loop
+    const uint64_t Mask = (uint64_t{1} << NumBits) - 1;
+    uint64_t Pool = mBitPool;
+    uint32_t BitCount = mBitCount;
+
+    for (uint32_t Idx = 0; Idx < Count; Idx++)
+    {
+        Pool |= (static_cast<uint32_t>(pkValues[Idx]) & Mask) << BitCount;
+        BitCount += NumBits;
+
+        if (BitCount >= 32)
+        {
+            mBitPool = Pool;
+            mBitCount = BitCount;
+            DrainPool();
+            Pool = mBitPool;
+            BitCount = mBitCount;
+        }
+    }
+
+    mBitPool = Pool;
+    mBitCount = BitCount;
+}
+
+void CBitStreamOutWrapper::Flush()
+{
+    DrainPool();
+
+    // Round the last partial chunk up to a whole one
+    if (mBitCount > 0)
+    {
+        mBitCount = mChunkSize;
+        DrainPool();
+    }
+
+    FlushBuffer();
+}
+
+// ************ PRIVATE ************
+void CBitStreamOutWrapper::DrainPool()
+{
+    const uint32_t ChunkBytes = mChunkSize / 8;
+
+    while (mBitCount >= static_cast<uint32_t>(mChunkSize))
+    {
+        if (skBufferSize - mBufferFill < ChunkBytes)
+            FlushBuffer();
+
+        uint8_t *pChunk = &mBuffer[mBufferFill];
+        const uint64_t Chunk = mBitPool & ((uint64_t{1} << mChunkSize) - 1);
+
+        if (mDestEndianness == std::endian::little)
+        {
+            for (uint32_t ByteIdx = 0; ByteIdx < ChunkBytes; ByteIdx++)
+                pChunk[ByteIdx] = static_cast<uint8_t>(Chunk >> (ByteIdx * 8));
+        }
+        else
+        {
+            for (uint32_t ByteIdx = 0; ByteIdx < ChunkBytes; ByteIdx++)
+                pChunk[ByteIdx] = static_cast<uint8_t>(Chunk >> ((ChunkBytes - 1 - ByteIdx) * 8));
+        }
+
+        mBufferFill += ChunkBytes;
+        mBitPool >>= mChunkSize;
+        mBitCount -= mChunkSize;
+    }
+}
+
+void CBitStreamOutWrapper::FlushBuffer()
+{
+    if (mBufferFill > 0)
+    {
+        mpDestStream->WriteBytes(mBuffer.data(), mBufferFill);
+        mBufferFill = 0;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef AXIO_CBITSTREAMOUTWRAPPER_H
+#define AXIO_CBITSTREAMOUTWRAPPER_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+class IOutputStream;
+
+// Writes bit-packed data to a stream in the layout CBitStreamInWrapper reads: bits fill chunks of
+// 8, 16 or 32 bits LSB-first, and each chunk is written in the stream's endianness. Completed
+// chunks are collected in a small byte buffer, so call Flush() (or destroy the wrapper) before
+// writing to the destination directly again. Flush() pads the final partial chunk with zeroes.
+class CBitStreamOutWrapper
+{
+public:
+    enum EChunkSize
+    {
+        k8Bit = 8, k16Bit = 16, k32Bit = 32
+    };
+
+private:
+    static constexpr uint32_t skBufferSize = 0x100;
+
+    IOutputStream *mpDestStream = nullptr;
+    EChunkSize mChunkSize{k32Bit};
+    std::endian mDestEndianness = std::endian::little;
+    uint64_t mBitPool = 0;
+    uint32_t mBitCount = 0;
+
+    std::array<uint8_t, skBufferSize> mBuffer{};
+    uint32_t mBufferFill = 0;
+
+public:
+    explicit CBitStreamOutWrapper(IOutputStream *pStream, EChunkSize ChunkSize = k32Bit);
+    ~CBitStreamOutWrapper();
+
+    CBitStreamOutWrapper(const CBitStreamOutWrapper&) = delete;
+    CBitStreamOutWrapper& operator=(const CBitStreamOutWrapper&) = delete;
+
+    /** Pads out the current chunk before switching, so switch on a chunk boundary to round-trip */
+    void SetChunkSize(EChunkSize Size);
+    void WriteBits(uint32_t Value, uint32_t NumBits);
+    void WriteBit(bool Bit);
+
+    /** Writes Count consecutive fields of NumBits bits each; equivalent to calling WriteBits() Count times */
+    void WriteBitsBatch(uint32_t Count, uint32_t NumBits, const int32_t *pkValues);
+
+    /** Writes out all pending bits, padding the last chunk with zeroes */
+    void Flush();
+
+private:
+    void DrainPool();
+    void FlushBuffer();
+};
+
+#endif // AXIO_CBITSTREAMOUTWRAPPER_H
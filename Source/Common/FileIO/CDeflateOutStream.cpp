@@ -0,0 +1,225 @@
+#include "CDeflateOutStream.h"
+
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <limits>
+#include <zlib.h>
+
+namespace
+{
+
+// zlib counts bytes in uInt, so anything larger has to be fed to it in pieces
+constexpr size_t kMaxZlibChunk = std::numeric_limits<uInt>::max();
+
+} // anonymous namespace
+
+CDeflateOutStream::CDeflateOutStream() = default;
+
+CDeflateOutStream::CDeflateOutStream(IOutputStream *pDest, int Level)
+{
+    Open(pDest, Level);
+}
+
+CDeflateOutStream::~CDeflateOutStream()
+{
+    Finish();
+}
+
+void CDeflateOutStream::Open(IOutputStream *pDest, int Level)
+{
+    Finish();
+
+    if (!pDest || !pDest->IsValid())
+        return;
+
+    mDataEndianness = pDest->GetEndianness();
+    mpZStream = std::make_unique<z_stream>();
+
+    if (deflateInit(mpZStream.get(), Level) != Z_OK)
+    {
+        NLog::Error("Failed to initialize zlib compression");
+        mpZStream.reset();
+        return;
+    }
+
+    if (mOutputBuffer.empty())
+        mOutputBuffer.resize(skOutputBufferSize);
+
+    mpDest = pDest;
+    mDestStart = pDest->Tell();
+    mPos = 0;
+    mError = false;
+}
+
+bool CDeflateOutStream::Finish()
+{
+    if (!mpZStream)
+        return !mError;
+
+    if (!mError)
+        Deflate(nullptr, 0, Z_FINISH);
+
+    deflateEnd(mpZStream.get());
+    mpZStream.reset();
+    return !mError;
+}
+
+uint64_t CDeflateOutStream::CompressedSize() const
+{
+    return mpDest ? mpDest->Tell() - mDestStart : 0;
+}
+
+void CDeflateOutStream::WriteBytes(const void *pkSrc, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    if (Deflate(static_cast<const uint8_t*>(pkSrc), Count, Z_NO_FLUSH))
+        mPos += Count;
+}
+
+bool CDeflateOutStream::Seek(int64_t Offset, uint32_t Origin)
+{
+    if (!IsValid())
+        return false;
+
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < static_cast<int64_t>(mPos))
+    {
+        NLog::Error("Compressed output streams can't seek backward");
+        return false;
+    }
+
+    static constexpr uint8_t skZeroes[0x1000] = {};
+
+    while (mPos < static_cast<uint64_t>(NewPos) && !mError)
+        WriteBytes(skZeroes, static_cast<size_t>(std::min<uint64_t>(sizeof(skZeroes), NewPos - mPos)));
+
+    return !mError;
+}
+
+uint64_t CDeflateOutStream::Tell() const
+{
+    return mPos;
+}
+
+bool CDeflateOutStream::EoF() const
+{
+    return false;
+}
+
+bool CDeflateOutStream::IsValid() const
+{
+    return mpZStream != nullptr && !mError && mpDest->IsValid();
+}
+
+uint64_t CDeflateOutStream::Size() const
+{
+    return mPos;
+}
+
+void CDeflateOutStream::PatchBytes(uint64_t /*Offset*/, const void* /*pkSrc*/, size_t /*Count*/)
+{
+    // Data that has already been compressed can't be changed
+    NLog::Error("Compressed output streams don't support patching");
+    mError = true;
+}
+
+size_t CDeflateOutStream::CompressBound(size_t SrcSize)
+{
+    return compressBound(static_cast<uLong>(SrcSize));
+}
+
+bool CDeflateOutStream::Compress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize, int Level)
+{
+    rOutSize = 0;
+    z_stream ZStream{};
+
+    if (deflateInit(&ZStream, Level) != Z_OK)
+        return false;
+
+    ZStream.next_in = const_cast<Bytef*>(Src.data());
+    ZStream.next_out = Dst.data();
+    int Result = Z_OK;
+
+    while (Result == Z_OK)
+    {
+        const size_t InRemaining = Src.size() - (ZStream.next_in - Src.data());
+        const size_t OutRemaining = Dst.size() - (ZStream.next_out - Dst.data());
+
+        if (ZStream.avail_in == 0)
+            ZStream.avail_in = static_cast<uInt>(std::min(InRemaining, kMaxZlibChunk));
+        if (ZStream.avail_out == 0)
+            ZStream.avail_out = static_cast<uInt>(std::min(OutRemaining, kMaxZlibChunk));
+
+        // Z_FINISH can only be requested once all of the input has been handed over
+        const bool LastInput = (ZStream.avail_in == InRemaining);
+        Result = deflate(&ZStream, LastInput ? Z_FINISH : Z_NO_FLUSH);
+    }
+
+    rOutSize = static_cast<size_t>(ZStream.next_out - Dst.data());
+    deflateEnd(&ZStream);
+    return (Result == Z_STREAM_END);
+}
+
+// ************ PRIVATE ************
+bool CDeflateOutStream::Deflate(const uint8_t *pkSrc, size_t Count, int Flush)
+{
+    z_stream& rZStream = *mpZStream;
+
+    do
+    {
+        const size_t NumInput = std::min(Count, kMaxZlibChunk);
+        const bool LastChunk = (NumInput == Count);
+
+        rZStream.next_in = const_cast<Bytef*>(pkSrc);
+        rZStream.avail_in = static_cast<uInt>(NumInput);
+
+        // Drain the compressor into the output buffer, writing it out whenever it fills up
+        int Result;
+
+        do
+        {
+            rZStream.next_out = mOutputBuffer.data();
+            rZStream.avail_out = static_cast<uInt>(mOutputBuffer.size());
+
+            Result = deflate(&rZStream, LastChunk ? Flush : Z_NO_FLUSH);
+
+            if (Result == Z_STREAM_ERROR)
+            {
+                NLog::Error("zlib compression failed: {}", rZStream.msg ? rZStream.msg : "unknown error");
+                mError = true;
+                return false;
+            }
+
+            const size_t NumOutput = mOutputBuffer.size() - rZStream.avail_out;
+
+            if (NumOutput > 0)
+                mpDest->WriteBytes(mOutputBuffer.data(), NumOutput);
+        }
+        while (rZStream.avail_out == 0);
+
+        pkSrc += NumInput;
+        Count -= NumInput;
+    }
+    while (Count > 0);
+
+    return true;
+}
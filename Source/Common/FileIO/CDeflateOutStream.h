@@ -0,0 +1,63 @@
+#ifndef AXIO_CDEFLATEOUTSTREAM_H
+#define AXIO_CDEFLATEOUTSTREAM_H
+
+#include "IOutputStream.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+struct z_stream_s;
+
+// Compresses everything written to it into a zlib stream on another output stream. The output
+// is finalized by Finish(), which the destructor calls if it hasn't been already. Only forward
+// seeks are supported (the gap is written as zeroes), so fields can't be patched after the fact.
+class CDeflateOutStream : public IOutputStream
+{
+    IOutputStream *mpDest = nullptr;
+    uint64_t mDestStart = 0;
+    uint64_t mPos = 0;
+
+    std::unique_ptr<z_stream_s> mpZStream;
+    std::vector<uint8_t> mOutputBuffer;
+    bool mError = false;
+
+public:
+    static constexpr uint32_t skOutputBufferSize = 0x10000;
+    static constexpr int skDefaultLevel = -1;
+
+    CDeflateOutStream();
+    explicit CDeflateOutStream(IOutputStream *pDest, int Level = skDefaultLevel);
+    ~CDeflateOutStream() override;
+
+    CDeflateOutStream(const CDeflateOutStream&) = delete;
+    CDeflateOutStream& operator=(const CDeflateOutStream&) = delete;
+
+    /** Starts a new zlib stream at the destination stream's current position */
+    void Open(IOutputStream *pDest, int Level = skDefaultLevel);
+    bool Finish();
+    uint64_t CompressedSize() const;
+
+    void WriteBytes(const void* pkSrc, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
+    bool EoF() const override;
+    bool IsValid() const override;
+    uint64_t Size() const override;
+    void PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count) override;
+
+    /** Returns the worst-case compressed size for SrcSize bytes of input */
+    static size_t CompressBound(size_t SrcSize);
+
+    /**
+     * Compresses Src into Dst as a complete zlib stream in a single pass.
+     * rOutSize receives the compressed size. Returns false if Dst is too small.
+     */
+    static bool Compress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize, int Level = skDefaultLevel);
+
+private:
+    bool Deflate(const uint8_t *pkSrc, size_t Count, int Flush);
+};
+
+#endif // AXIO_CDEFLATEOUTSTREAM_H
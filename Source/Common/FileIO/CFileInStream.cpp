@@ -1,11 +1,38 @@
 #include "CFileInStream.h"
 
+#include <algorithm>
+#include <cstring>
 #include <utility>
 
+#ifdef _WIN32
+#include <Windows.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+size_t ReadFromFile(void *pDst, size_t Count, FILE *pFile, bool Unlocked)
+{
+#ifdef _WIN32
+    return Unlocked ? _fread_nolock(pDst, 1, Count, pFile) : fread(pDst, 1, Count, pFile);
+#else
+    (void) Unlocked;
+    return fread(pDst, 1, Count, pFile);
+#endif
+}
+
+} // anonymous namespace
+
 CFileInStream::CFileInStream() = default;
 
-CFileInStream::CFileInStream(const TString& rkFile, std::endian FileEndianness)
+CFileInStream::CFileInStream(const TString& rkFile, std::endian FileEndianness, uint32_t BufferSize, bool Unlocked)
+    : mUnlocked(Unlocked)
 {
+    SetBufferSize(BufferSize);
     Open(rkFile, FileEndianness);
 }
 
@@ -19,6 +46,18 @@ CFileInStream::CFileInStream(CFileInStream&& Other) noexcept
     : mpFStream{std::exchange(Other.mpFStream, nullptr)}
     , mName{std::exchange(Other.mName, TString())}
     , mFileSize{std::exchange(Other.mFileSize, 0)}
+    , mBuffer{std::move(Other.mBuffer)}
+    , mReadaheadSize{std::exchange(Other.mReadaheadSize, 0)}
+    , mBufferOffset{std::exchange(Other.mBufferOffset, 0)}
+    , mBufferFill{std::exchange(Other.mBufferFill, 0)}
+    , mPos{std::exchange(Other.mPos, 0)}
+    , mFilePos{std::exchange(Other.mFilePos, 0)}
+    , mUnlocked{Other.mUnlocked}
+#ifdef _WIN32
+    , mhReadAtFile{std::exchange(Other.mhReadAtFile, nullptr)}
+#else
+    , mFileDesc{std::exchange(Other.mFileDesc, -1)}
+#endif
 {
     mDataEndianness = Other.mDataEndianness;
     mDataSource = std::exchange(Other.mDataSource, TString());
@@ -29,9 +68,24 @@ CFileInStream& CFileInStream::operator=(CFileInStream&& Other) noexcept
     if (this == &Other)
         return *this;
 
+    if (IsValid())
+        Close();
+
     mpFStream = std::exchange(Other.mpFStream, nullptr);
     mName = std::exchange(Other.mName, TString());
     mFileSize = std::exchange(Other.mFileSize, 0);
+    mBuffer = std::move(Other.mBuffer);
+    mReadaheadSize = std::exchange(Other.mReadaheadSize, 0);
+    mBufferOffset = std::exchange(Other.mBufferOffset, 0);
+    mBufferFill = std::exchange(Other.mBufferFill, 0);
+    mPos = std::exchange(Other.mPos, 0);
+    mFilePos = std::exchange(Other.mFilePos, 0);
+    mUnlocked = Other.mUnlocked;
+#ifdef _WIN32
+    mhReadAtFile = std::exchange(Other.mhReadAtFile, nullptr);
+#else
+    mFileDesc = std::exchange(Other.mFileDesc, -1);
+#endif
     mDataEndianness = Other.mDataEndianness;
     mDataSource = std::exchange(Other.mDataSource, TString());
     return *this;
@@ -49,12 +103,32 @@ void CFileInStream::Open(const TString& rkFile, std::endian FileEndianness)
 #endif
     mName = rkFile;
     mDataEndianness = FileEndianness;
+    mBufferOffset = 0;
+    mBufferFill = 0;
+    mPos = 0;
+    mFilePos = 0;
 
     if (IsValid())
     {
-        Seek(0x0, SEEK_END);
-        mFileSize = Tell();
-        Seek(0x0, SEEK_SET);
+        SetStdioLocking(mpFStream, mUnlocked);
+
+#ifdef _WIN32
+        // A second handle with its own file pointer; reads on the CRT's handle would move the FILE
+        HANDLE hReadAtFile = ReOpenFile(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(mpFStream))), GENERIC_READ,
+                                        FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_FLAG_RANDOM_ACCESS);
+        mhReadAtFile = (hReadAtFile != INVALID_HANDLE_VALUE ? hReadAtFile : nullptr);
+
+        _fseeki64(mpFStream, 0, SEEK_END);
+        mFileSize = _ftelli64(mpFStream);
+        _fseeki64(mpFStream, 0, SEEK_SET);
+#else
+        // pread doesn't touch the file offset, so the FILE's own descriptor can be shared
+        mFileDesc = fileno(mpFStream);
+
+        fseeko(mpFStream, 0, SEEK_END);
+        mFileSize = ftello(mpFStream);
+        fseeko(mpFStream, 0, SEEK_SET);
+#endif
     }
     else
     {
@@ -68,52 +142,178 @@ void CFileInStream::Close()
 {
     if (IsValid())
         fclose(mpFStream);
+#ifdef _WIN32
+    if (mhReadAtFile)
+        CloseHandle(mhReadAtFile);
+    mhReadAtFile = nullptr;
+#else
+    mFileDesc = -1;
+#endif
     mpFStream = nullptr;
+    mBufferOffset = 0;
+    mBufferFill = 0;
+    mPos = 0;
+    mFilePos = 0;
 }
 
-void CFileInStream::ReadBytes(void *pDst, uint32_t Count)
+void CFileInStream::SetBufferSize(uint32_t BufferSize)
 {
-    if (!IsValid())
-        return;
+    // Switching modes; carry the current position over so reads continue from the same spot
+    if (IsValid())
+    {
+        const uint64_t Position = Tell();
+
+        if (BufferSize == 0)
+        {
+#ifdef _WIN32
+            _fseeki64(mpFStream, Position, SEEK_SET);
+#else
+            fseeko(mpFStream, Position, SEEK_SET);
+#endif
+        }
+        else if (!IsBuffered())
+        {
+            mFilePos = Position;
+        }
+
+        mPos = Position;
+    }
+
+    mBuffer.resize(BufferSize);
+    mBuffer.shrink_to_fit();
+    mBufferOffset = 0;
+    mBufferFill = 0;
+    mReadaheadSize = BufferSize;
+}
+
+void CFileInStream::SetReadaheadSize(uint32_t ReadaheadSize)
+{
+    mReadaheadSize = std::min<uint32_t>(ReadaheadSize, mBuffer.size());
+}
 
-    fread(pDst, 1, Count, mpFStream);
+uint32_t CFileInStream::BufferSize() const
+{
+    return mBuffer.size();
 }
 
-bool CFileInStream::Seek(int32_t Offset, uint32_t Origin)
+bool CFileInStream::IsBuffered() const
+{
+    return !mBuffer.empty();
+}
+
+void CFileInStream::SetUnlocked(bool Unlocked)
+{
+    mUnlocked = Unlocked;
+
+    if (IsValid())
+        SetStdioLocking(mpFStream, Unlocked);
+}
+
+bool CFileInStream::IsUnlocked() const
+{
+    return mUnlocked;
+}
+
+bool CFileInStream::SetAccessHint(EFileAccessHint Hint, uint64_t Offset /*= 0*/, uint64_t Length /*= 0*/)
+{
+    return IsValid() && AdviseFileAccess(mpFStream, Hint, Offset, Length);
+}
+
+void CFileInStream::ReadBytes(void *pDst, size_t Count)
 {
     if (!IsValid())
-        return false;
+        return;
 
-    return (fseek(mpFStream, Offset, Origin) == 0);
+    if (!IsBuffered())
+    {
+        ReadFromFile(pDst, Count, mpFStream, mUnlocked);
+        return;
+    }
+
+    auto* pOut = static_cast<char*>(pDst);
+
+    while (Count > 0)
+    {
+        // Serve as much as possible from the buffered window
+        if (mPos >= mBufferOffset && mPos < mBufferOffset + mBufferFill)
+        {
+            const auto BufferPos = static_cast<uint32_t>(mPos - mBufferOffset);
+            const auto NumBytes = std::min<size_t>(Count, mBufferFill - BufferPos);
+            memcpy(pOut, mBuffer.data() + BufferPos, NumBytes);
+            pOut += NumBytes;
+            mPos += NumBytes;
+            Count -= NumBytes;
+        }
+        // Reads that wouldn't fit in the buffer anyway go straight to the destination
+        else if (Count >= mBuffer.size())
+        {
+            if (!SyncFilePosition(mPos))
+                return;
+
+            const auto NumRead = ReadFromFile(pOut, Count, mpFStream, mUnlocked);
+            mPos += NumRead;
+            mFilePos = mPos;
+            return;
+        }
+        else if (!FillBuffer(Count))
+        {
+            return;
+        }
+    }
 }
 
-bool CFileInStream::Seek64(int64_t Offset, uint32_t Origin)
+bool CFileInStream::Seek(int64_t Offset, uint32_t Origin)
 {
     if (!IsValid())
         return false;
 
+    if (IsBuffered())
+    {
+        // Only the logical position moves; the FILE is repositioned lazily on the next refill
+        int64_t NewPos;
+
+        switch (Origin)
+        {
+            case SEEK_SET:
+                NewPos = Offset;
+                break;
+
+            case SEEK_CUR:
+                NewPos = static_cast<int64_t>(mPos) + Offset;
+                break;
+
+            case SEEK_END:
+                NewPos = static_cast<int64_t>(mFileSize) + Offset;
+                break;
+
+            default:
+                return false;
+        }
+
+        if (NewPos < 0)
+            return false;
+
+        mPos = static_cast<uint64_t>(NewPos);
+        return true;
+    }
+
 #ifdef _WIN32
-    return (_fseeki64(mpFStream, Offset, Origin) == 0);
+    return ((mUnlocked ? _fseeki64_nolock(mpFStream, Offset, Origin) : _fseeki64(mpFStream, Offset, Origin)) == 0);
 #else
     return (fseeko(mpFStream, Offset, Origin) == 0);
 #endif
 }
 
-uint32_t CFileInStream::Tell() const
+uint64_t CFileInStream::Tell() const
 {
     if (!IsValid())
         return 0;
 
-    return ftell(mpFStream);
-}
-
-uint64_t CFileInStream::Tell64() const
-{
-    if (!IsValid())
-        return 0;
+    if (IsBuffered())
+        return mPos;
 
 #ifdef _WIN32
-    return _ftelli64(mpFStream);
+    return mUnlocked ? _ftelli64_nolock(mpFStream) : _ftelli64(mpFStream);
 #else
     return ftello(mpFStream);
 #endif
@@ -129,7 +329,7 @@ bool CFileInStream::IsValid() const
     return (mpFStream != 0);
 }
 
-uint32_t CFileInStream::Size() const
+uint64_t CFileInStream::Size() const
 {
     return mFileSize;
 }
@@ -138,3 +338,93 @@ TString CFileInStream::FileName() const
 {
     return mName;
 }
+
+const void* CFileInStream::BufferedDataAtPosition(size_t& rOutSize) const
+{
+    rOutSize = 0;
+
+    if (!IsBuffered() || mPos < mBufferOffset || mPos >= mBufferOffset + mBufferFill)
+        return nullptr;
+
+    const auto BufferPos = static_cast<uint32_t>(mPos - mBufferOffset);
+    rOutSize = mBufferFill - BufferPos;
+    return mBuffer.data() + BufferPos;
+}
+
+bool CFileInStream::SupportsReadAt() const
+{
+    return true;
+}
+
+size_t CFileInStream::ReadAt(uint64_t Offset, void *pDst, size_t Count) const
+{
+    if (!IsValid() || Offset >= mFileSize)
+        return 0;
+
+    Count = static_cast<size_t>(std::min<uint64_t>(Count, mFileSize - Offset));
+    auto *pOut = static_cast<char*>(pDst);
+    size_t NumRead = 0;
+
+    while (NumRead < Count)
+    {
+        const uint64_t ReadOffset = Offset + NumRead;
+
+#ifdef _WIN32
+        if (!mhReadAtFile)
+            break;
+
+        OVERLAPPED Overlapped{};
+        Overlapped.Offset = static_cast<DWORD>(ReadOffset);
+        Overlapped.OffsetHigh = static_cast<DWORD>(ReadOffset >> 32);
+        const auto NumToRead = static_cast<DWORD>(std::min<size_t>(Count - NumRead, 0x7FFFF000));
+        DWORD NumReadNow = 0;
+
+        if (!ReadFile(mhReadAtFile, pOut + NumRead, NumToRead, &NumReadNow, &Overlapped) || NumReadNow == 0)
+            break;
+#else
+        const ssize_t NumReadNow = pread(mFileDesc, pOut + NumRead, Count - NumRead, static_cast<off_t>(ReadOffset));
+
+        if (NumReadNow < 0 && errno == EINTR)
+            continue;
+
+        if (NumReadNow <= 0)
+            break;
+#endif
+
+        NumRead += static_cast<size_t>(NumReadNow);
+    }
+
+    return NumRead;
+}
+
+// ************ PRIVATE ************
+bool CFileInStream::FillBuffer(size_t MinSize)
+{
+    if (!SyncFilePosition(mPos))
+        return false;
+
+    const auto ReadSize = std::min<size_t>(std::max<size_t>(mReadaheadSize, MinSize), mBuffer.size());
+    const auto NumRead = ReadFromFile(mBuffer.data(), ReadSize, mpFStream, mUnlocked);
+
+    mBufferOffset = mPos;
+    mBufferFill = static_cast<uint32_t>(NumRead);
+    mFilePos = mPos + NumRead;
+    return NumRead > 0;
+}
+
+bool CFileInStream::SyncFilePosition(uint64_t Position)
+{
+    if (mFilePos == Position)
+        return true;
+
+#ifdef _WIN32
+    const bool Success = ((mUnlocked ? _fseeki64_nolock(mpFStream, Position, SEEK_SET) : _fseeki64(mpFStream, Position, SEEK_SET)) == 0);
+#else
+    const bool Success = (fseeko(mpFStream, Position, SEEK_SET) == 0);
+#endif
+
+    if (Success)
+        mFilePos = Position;
+
+    return Success;
+}
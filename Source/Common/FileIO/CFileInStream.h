@@ -1,18 +1,40 @@
 #ifndef AXIO_CFILEINSTREAM_H
 #define AXIO_CFILEINSTREAM_H
 
+#include "EFileAccessHint.h"
 #include "IInputStream.h"
 
+#include <vector>
+
 class CFileInStream : public IInputStream
 {
 private:
     FILE *mpFStream = nullptr;
     TString mName;
-    uint32_t mFileSize = 0;
+    uint64_t mFileSize = 0;
+
+    // Optional user-space read buffer. When enabled, primitive reads, peeks and short seeks
+    // are served from memory and the FILE is only touched to refill the buffer.
+    std::vector<char> mBuffer;
+    uint32_t mReadaheadSize = 0;    // Number of bytes requested per refill
+    uint64_t mBufferOffset = 0;     // File offset of mBuffer[0]
+    uint32_t mBufferFill = 0;       // Number of valid bytes in mBuffer
+    uint64_t mPos = 0;              // Logical read position (buffered mode only)
+    uint64_t mFilePos = 0;          // Actual FILE position (buffered mode only)
+    bool mUnlocked = false;         // Skip stdio locking; the stream is only used from one thread
+
+    // Separate handle for ReadAt(), so positional reads never disturb the FILE's own position
+#ifdef _WIN32
+    void *mhReadAtFile = nullptr;
+#else
+    int mFileDesc = -1;
+#endif
 
 public:
+    static constexpr uint32_t skDefaultBufferSize = 0x40000;
+
     CFileInStream();
-    explicit CFileInStream(const TString& rkFile, std::endian FileEndianness);
+    explicit CFileInStream(const TString& rkFile, std::endian FileEndianness, uint32_t BufferSize = 0, bool Unlocked = false);
     ~CFileInStream() override;
 
     CFileInStream(const CFileInStream&) = delete;
@@ -23,16 +45,35 @@ public:
 
     void Open(const TString& rkFile, std::endian FileEndianness);
     void Close();
+    void SetBufferSize(uint32_t BufferSize);
+    void SetReadaheadSize(uint32_t ReadaheadSize);
+    uint32_t BufferSize() const;
+    bool IsBuffered() const;
 
-    void ReadBytes(void* pDst, uint32_t Count) override;
-    bool Seek(int32_t Offset, uint32_t Origin) override;
-    bool Seek64(int64_t Offset, uint32_t Origin) override;
-    uint32_t Tell() const override;
-    uint64_t Tell64() const override;
+    /**
+     * Stops stdio from locking the FILE on every read, seek and tell. Only safe while the stream
+     * is used from a single thread, which is how streams are normally used anyway.
+     */
+    void SetUnlocked(bool Unlocked);
+    bool IsUnlocked() const;
+
+    /** Passes an access pattern hint for a range of the file on to the OS. Length 0 means to the end. */
+    bool SetAccessHint(EFileAccessHint Hint, uint64_t Offset = 0, uint64_t Length = 0);
+
+    void ReadBytes(void* pDst, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
     bool EoF() const override;
     bool IsValid() const override;
-    uint32_t Size() const override;
+    uint64_t Size() const override;
     TString FileName() const;
+    const void* BufferedDataAtPosition(size_t& rOutSize) const override;
+    bool SupportsReadAt() const override;
+    size_t ReadAt(uint64_t Offset, void *pDst, size_t Count) const override;
+
+private:
+    bool FillBuffer(size_t MinSize);
+    bool SyncFilePosition(uint64_t Position);
 };
 
 #endif // AXIO_CFILEINSTREAM_H
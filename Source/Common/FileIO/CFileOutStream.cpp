@@ -1,11 +1,44 @@
 #include "CFileOutStream.h"
 
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <cstring>
 #include <utility>
 
+#ifdef _WIN32
+#include <Windows.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+size_t WriteToFile(const void *pkSrc, size_t Count, FILE *pFile, bool Unlocked)
+{
+#ifdef _WIN32
+    return Unlocked ? _fwrite_nolock(pkSrc, 1, Count, pFile) : fwrite(pkSrc, 1, Count, pFile);
+#else
+    (void) Unlocked;
+    return fwrite(pkSrc, 1, Count, pFile);
+#endif
+}
+
+} // anonymous namespace
+
 CFileOutStream::CFileOutStream() = default;
 
-CFileOutStream::CFileOutStream(const TString& rkFile, std::endian FileEndianness)
+CFileOutStream::CFileOutStream(const TString& rkFile, std::endian FileEndianness, uint32_t BufferSize, EFileSyncPolicy SyncPolicy, bool Unlocked)
+    : mSyncPolicy(SyncPolicy)
+    , mUnlocked(Unlocked)
 {
+    SetBufferSize(BufferSize);
     Open(rkFile, FileEndianness);
 }
 
@@ -18,7 +51,20 @@ CFileOutStream::~CFileOutStream()
 CFileOutStream::CFileOutStream(CFileOutStream&& Other) noexcept
     : mpFStream{std::exchange(Other.mpFStream, nullptr)}
     , mName{std::exchange(Other.mName, TString())}
+    , mTempName{std::exchange(Other.mTempName, TString())}
     , mSize{std::exchange(Other.mSize, 0)}
+    , mPos{std::exchange(Other.mPos, 0)}
+    , mFilePos{std::exchange(Other.mFilePos, 0)}
+    , mSyncPolicy{Other.mSyncPolicy}
+    , mWriteFailed{std::exchange(Other.mWriteFailed, false)}
+    , mDropCacheOnFlush{Other.mDropCacheOnFlush}
+    , mUnlocked{Other.mUnlocked}
+    , mBuffer{std::move(Other.mBuffer)}
+    , mBufferOffset{std::exchange(Other.mBufferOffset, 0)}
+    , mBufferFill{std::exchange(Other.mBufferFill, 0)}
+    , mPendingPatches{std::move(Other.mPendingPatches)}
+    , mPatchRangeStart{std::exchange(Other.mPatchRangeStart, 0)}
+    , mPatchRangeEnd{std::exchange(Other.mPatchRangeEnd, 0)}
 {
     mDataEndianness = Other.mDataEndianness;
 }
@@ -28,9 +74,25 @@ CFileOutStream& CFileOutStream::operator=(CFileOutStream&& Other) noexcept
     if (this == &Other)
         return *this;
 
+    if (IsValid())
+        Close();
+
     mpFStream = std::exchange(Other.mpFStream, nullptr);
     mName = std::exchange(Other.mName, TString());
+    mTempName = std::exchange(Other.mTempName, TString());
     mSize = std::exchange(Other.mSize, 0);
+    mPos = std::exchange(Other.mPos, 0);
+    mFilePos = std::exchange(Other.mFilePos, 0);
+    mSyncPolicy = Other.mSyncPolicy;
+    mWriteFailed = std::exchange(Other.mWriteFailed, false);
+    mDropCacheOnFlush = Other.mDropCacheOnFlush;
+    mUnlocked = Other.mUnlocked;
+    mBuffer = std::move(Other.mBuffer);
+    mBufferOffset = std::exchange(Other.mBufferOffset, 0);
+    mBufferFill = std::exchange(Other.mBufferFill, 0);
+    mPendingPatches = std::move(Other.mPendingPatches);
+    mPatchRangeStart = std::exchange(Other.mPatchRangeStart, 0);
+    mPatchRangeEnd = std::exchange(Other.mPatchRangeEnd, 0);
     mDataEndianness = Other.mDataEndianness;
     return *this;
 }
@@ -40,14 +102,26 @@ void CFileOutStream::Open(const TString& rkFile, std::endian FileEndianness)
     if (IsValid())
         Close();
 
+    // For atomic replacement, the destination is left untouched until Close() succeeds
+    mTempName = (mSyncPolicy == EFileSyncPolicy::AtomicReplace ? rkFile + ".tmp" : TString());
+    const TString& rkOpenName = (mTempName.IsEmpty() ? rkFile : mTempName);
+
 #ifdef _WIN32
-    _wfopen_s(&mpFStream, ToWChar(rkFile), L"wb");
+    _wfopen_s(&mpFStream, ToWChar(rkOpenName), L"wb");
 #else
-    mpFStream = fopen(rkFile.data(), "wb");
+    mpFStream = fopen(rkOpenName.data(), "wb");
 #endif
     mName = rkFile;
     mDataEndianness = FileEndianness;
     mSize = 0;
+    mPos = 0;
+    mFilePos = 0;
+    mBufferOffset = 0;
+    mBufferFill = 0;
+    mWriteFailed = false;
+
+    if (IsValid())
+        SetStdioLocking(mpFStream, mUnlocked);
 }
 
 void CFileOutStream::Update(const TString& rkFile, std::endian FileEndianness)
@@ -55,6 +129,9 @@ void CFileOutStream::Update(const TString& rkFile, std::endian FileEndianness)
     if (IsValid())
         Close();
 
+    // Updating in place can't be done atomically; the file is modified directly
+    mTempName = TString();
+
 #ifdef _WIN32
     _wfopen_s(&mpFStream, ToWChar(rkFile), L"rb+");
 #else
@@ -62,68 +139,242 @@ void CFileOutStream::Update(const TString& rkFile, std::endian FileEndianness)
 #endif
     mName = rkFile;
     mDataEndianness = FileEndianness;
-    Seek(0x0, SEEK_END);
-    mSize = Tell();
-    Seek(0x0, SEEK_SET);
+    mPos = 0;
+    mFilePos = 0;
+    mBufferOffset = 0;
+    mBufferFill = 0;
+    mWriteFailed = false;
+
+    if (IsValid())
+    {
+        SetStdioLocking(mpFStream, mUnlocked);
+
+#ifdef _WIN32
+        _fseeki64(mpFStream, 0, SEEK_END);
+        mSize = _ftelli64(mpFStream);
+        _fseeki64(mpFStream, 0, SEEK_SET);
+#else
+        fseeko(mpFStream, 0, SEEK_END);
+        mSize = ftello(mpFStream);
+        fseeko(mpFStream, 0, SEEK_SET);
+#endif
+    }
+    else
+    {
+        mSize = 0;
+    }
 }
 
-void CFileOutStream::Close()
+bool CFileOutStream::Close()
 {
-    if (IsValid())
-        fclose(mpFStream);
+    bool Success = IsValid();
+
+    if (Success)
+    {
+        Success = FlushBuffer();
+        ApplyPendingPatches();
+        Success = Success && !mWriteFailed && fflush(mpFStream) == 0;
+
+        if (Success && mSyncPolicy != EFileSyncPolicy::None)
+            Success = SyncToDisk();
+
+        if (Success && mDropCacheOnFlush)
+            Success = DropFileCache(mpFStream);
+
+        Success = (fclose(mpFStream) == 0) && Success;
+
+        if (!mTempName.IsEmpty())
+        {
+#ifdef _WIN32
+            if (Success)
+                Success = MoveFileExW(ToWChar(mTempName), ToWChar(mName), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+            if (!Success)
+                _wremove(ToWChar(mTempName));
+#else
+            if (Success)
+                Success = (rename(mTempName.CString(), mName.CString()) == 0);
+            if (!Success)
+                remove(mTempName.CString());
+#endif
+
+            if (!Success)
+                NLog::Error("{}: Failed to write file; the previous contents were left in place", mName);
+        }
+    }
+
     mpFStream = nullptr;
+    mTempName = TString();
     mSize = 0;
+    mPos = 0;
+    mFilePos = 0;
+    mBufferOffset = 0;
+    mBufferFill = 0;
+    mWriteFailed = false;
+    mPendingPatches.clear();
+    return Success;
 }
 
-void CFileOutStream::WriteBytes(const void *pkSrc, uint32_t Count)
+bool CFileOutStream::Flush()
 {
     if (!IsValid())
-        return;
+        return false;
+
+    bool Success = FlushBuffer();
+    ApplyPendingPatches();
+    Success = Success && !mWriteFailed && fflush(mpFStream) == 0;
+
+    if (Success && mDropCacheOnFlush)
+        Success = DropFileCache(mpFStream);
 
-    fwrite(pkSrc, 1, Count, mpFStream);
+    // Close() has to report this too, even if nothing else goes wrong before then
+    if (!Success)
+        mWriteFailed = true;
 
-    if (Tell() > mSize)
-        mSize = Tell();
+    return Success;
 }
 
-bool CFileOutStream::Seek(int32_t Offset, uint32_t Origin)
+void CFileOutStream::SetBufferSize(uint32_t BufferSize)
 {
-    if (!IsValid())
-        return false;
+    FlushBuffer();
+    mBuffer.resize(BufferSize);
+    mBuffer.shrink_to_fit();
+}
 
-    return (fseek(mpFStream, Offset, Origin) == 0);
+uint32_t CFileOutStream::BufferSize() const
+{
+    return mBuffer.size();
 }
 
-bool CFileOutStream::Seek64(int64_t Offset, uint32_t Origin)
+bool CFileOutStream::IsBuffered() const
 {
-    if (!IsValid())
-        return false;
+    return !mBuffer.empty();
+}
 
-#ifdef _WIN32
-    return (_fseeki64(mpFStream, Offset, Origin) == 0);
-#else
-    return (fseeko(mpFStream, Offset, Origin) == 0);
-#endif
+void CFileOutStream::SetSyncPolicy(EFileSyncPolicy Policy)
+{
+    // Switching to or from AtomicReplace only takes effect the next time a file is opened
+    mSyncPolicy = Policy;
+}
+
+EFileSyncPolicy CFileOutStream::SyncPolicy() const
+{
+    return mSyncPolicy;
+}
+
+bool CFileOutStream::SetAccessHint(EFileAccessHint Hint, uint64_t Offset /*= 0*/, uint64_t Length /*= 0*/)
+{
+    return IsValid() && AdviseFileAccess(mpFStream, Hint, Offset, Length);
+}
+
+void CFileOutStream::SetDropCacheOnFlush(bool Enable)
+{
+    mDropCacheOnFlush = Enable;
+}
+
+bool CFileOutStream::DropsCacheOnFlush() const
+{
+    return mDropCacheOnFlush;
+}
+
+void CFileOutStream::SetUnlocked(bool Unlocked)
+{
+    mUnlocked = Unlocked;
+
+    if (IsValid())
+        SetStdioLocking(mpFStream, Unlocked);
 }
 
-uint32_t CFileOutStream::Tell() const
+bool CFileOutStream::IsUnlocked() const
+{
+    return mUnlocked;
+}
+
+void CFileOutStream::WriteBytes(const void *pkSrc, size_t Count)
 {
     if (!IsValid())
-        return 0;
+        return;
+
+    if (!mPendingPatches.empty() && mPos < mPatchRangeEnd && mPos + Count > mPatchRangeStart)
+        ApplyPendingPatches();
+
+    // Writes that land inside or directly after the pending run are combined in the buffer
+    if (Count < mBuffer.size())
+    {
+        if (mBufferFill > 0)
+        {
+            const bool Fits = (mPos >= mBufferOffset && mPos <= mBufferOffset + mBufferFill &&
+                               (mPos - mBufferOffset) + Count <= mBuffer.size());
+            if (!Fits)
+                FlushBuffer();
+        }
 
-    return ftell(mpFStream);
+        if (mBufferFill == 0)
+            mBufferOffset = mPos;
+
+        const auto BufferPos = static_cast<uint32_t>(mPos - mBufferOffset);
+        memcpy(mBuffer.data() + BufferPos, pkSrc, Count);
+        mBufferFill = std::max(mBufferFill, static_cast<uint32_t>(BufferPos + Count));
+    }
+    else
+    {
+        FlushBuffer();
+
+        if (!SyncFilePosition(mPos))
+        {
+            mWriteFailed = true;
+            return;
+        }
+
+        const size_t NumWritten = WriteToFile(pkSrc, Count, mpFStream, mUnlocked);
+        mFilePos += NumWritten;
+
+        if (NumWritten != Count)
+        {
+            mWriteFailed = true;
+            Count = NumWritten;
+        }
+    }
+
+    mPos += Count;
+    mSize = std::max(mSize, mPos);
 }
 
-uint64_t CFileOutStream::Tell64() const
+bool CFileOutStream::Seek(int64_t Offset, uint32_t Origin)
 {
     if (!IsValid())
-        return 0;
+        return false;
 
-#ifdef _WIN32
-    return _ftelli64(mpFStream);
-#else
-    return ftello(mpFStream);
-#endif
+    // Only the logical position moves; the FILE is repositioned lazily on the next write
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mSize) + Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < 0)
+        return false;
+
+    mPos = static_cast<uint64_t>(NewPos);
+    return true;
+}
+
+uint64_t CFileOutStream::Tell() const
+{
+    return IsValid() ? mPos : 0;
 }
 
 bool CFileOutStream::EoF() const
@@ -136,7 +387,7 @@ bool CFileOutStream::IsValid() const
     return (mpFStream != 0);
 }
 
-uint32_t CFileOutStream::Size() const
+uint64_t CFileOutStream::Size() const
 {
     if (!IsValid())
         return 0;
@@ -144,7 +395,223 @@ uint32_t CFileOutStream::Size() const
     return mSize;
 }
 
+void CFileOutStream::PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    // Fields that are still sitting in the write buffer can be patched in place
+    if (mBufferFill > 0 && Offset >= mBufferOffset && Offset + Count <= mBufferOffset + mBufferFill)
+    {
+        memcpy(mBuffer.data() + (Offset - mBufferOffset), pkSrc, Count);
+        return;
+    }
+
+    // A partial overlap would be clobbered by the older buffered bytes when they're flushed
+    if (mBufferFill > 0 && Offset < mBufferOffset + mBufferFill && Offset + Count > mBufferOffset)
+        FlushBuffer();
+
+    if (Count > sizeof(SPendingPatch::Data))
+    {
+        IOutputStream::PatchBytes(Offset, pkSrc, Count);
+        return;
+    }
+
+    SPendingPatch Patch{Offset, 0, static_cast<uint32_t>(Count)};
+    memcpy(&Patch.Data, pkSrc, Count);
+
+    mPatchRangeStart = (mPendingPatches.empty() ? Offset : std::min(mPatchRangeStart, Offset));
+    mPatchRangeEnd = std::max(mPatchRangeEnd, Offset + Count);
+    mPendingPatches.push_back(Patch);
+}
+
+void CFileOutStream::WriteGather(std::span<const std::span<const uint8_t>> Buffers)
+{
+    if (!IsValid())
+        return;
+
+#ifdef _WIN32
+    // There's no gather write for regular buffered handles on Windows
+    IOutputStream::WriteGather(Buffers);
+#else
+    size_t TotalSize = 0;
+
+    for (const std::span<const uint8_t>& rkBuffer : Buffers)
+        TotalSize += rkBuffer.size();
+
+    // Small lists are better off combined in the write buffer
+    if (Buffers.size() < 2 || TotalSize < mBuffer.size())
+    {
+        IOutputStream::WriteGather(Buffers);
+        return;
+    }
+
+    if (!mPendingPatches.empty() && mPos < mPatchRangeEnd && mPos + TotalSize > mPatchRangeStart)
+        ApplyPendingPatches();
+
+    // Everything the FILE is holding has to reach the descriptor before we write to it directly
+    if (!FlushBuffer() || !SyncFilePosition(mPos) || fflush(mpFStream) != 0)
+    {
+        mWriteFailed = true;
+        return;
+    }
+
+#ifdef IOV_MAX
+    constexpr size_t kMaxIOVecs = IOV_MAX;
+#else
+    constexpr size_t kMaxIOVecs = 1024;
+#endif
+
+    const int FileDesc = fileno(mpFStream);
+    std::vector<iovec> IOVecs;
+    IOVecs.reserve(std::min(Buffers.size(), kMaxIOVecs));
+
+    size_t BufferIdx = 0;
+    size_t BufferOffset = 0;
+    uint64_t NumWritten = 0;
+
+    while (true)
+    {
+        IOVecs.clear();
+
+        for (size_t Idx = BufferIdx; Idx < Buffers.size() && IOVecs.size() < kMaxIOVecs; Idx++)
+        {
+            const size_t Offset = (Idx == BufferIdx ? BufferOffset : 0);
+
+            if (Buffers[Idx].size() > Offset)
+                IOVecs.push_back({const_cast<uint8_t*>(Buffers[Idx].data()) + Offset, Buffers[Idx].size() - Offset});
+        }
+
+        if (IOVecs.empty())
+            break;
+
+        const ssize_t Result = writev(FileDesc, IOVecs.data(), static_cast<int>(IOVecs.size()));
+
+        if (Result < 0 && errno == EINTR)
+            continue;
+
+        if (Result <= 0)
+        {
+            mWriteFailed = true;
+            break;
+        }
+
+        NumWritten += Result;
+
+        // Step past what was written; a short write resumes partway through a buffer
+        auto Remaining = static_cast<size_t>(Result);
+
+        while (Remaining > 0)
+        {
+            const size_t NumLeft = Buffers[BufferIdx].size() - BufferOffset;
+
+            if (Remaining < NumLeft)
+            {
+                BufferOffset += Remaining;
+                break;
+            }
+
+            Remaining -= NumLeft;
+            BufferIdx++;
+            BufferOffset = 0;
+        }
+    }
+
+    // The FILE's cached offset is stale now, so move it to where the descriptor ended up
+    mPos += NumWritten;
+    mSize = std::max(mSize, mPos);
+    mFilePos = mPos;
+
+    if (fseeko(mpFStream, mFilePos, SEEK_SET) != 0)
+        mWriteFailed = true;
+#endif
+}
+
 TString CFileOutStream::FileName() const
 {
     return mName;
 }
+
+// ************ PRIVATE ************
+bool CFileOutStream::FlushBuffer()
+{
+    if (mBufferFill == 0)
+        return true;
+
+    const uint32_t NumPending = mBufferFill;
+    mBufferFill = 0;
+
+    if (!SyncFilePosition(mBufferOffset))
+    {
+        mWriteFailed = true;
+        return false;
+    }
+
+    const size_t NumWritten = WriteToFile(mBuffer.data(), NumPending, mpFStream, mUnlocked);
+    mFilePos += NumWritten;
+
+    if (NumWritten != NumPending)
+    {
+        mWriteFailed = true;
+        return false;
+    }
+
+    return true;
+}
+
+void CFileOutStream::ApplyPendingPatches()
+{
+    if (mPendingPatches.empty())
+        return;
+
+    // Write in file order; the sort is stable so a later patch to the same field still wins
+    std::stable_sort(mPendingPatches.begin(), mPendingPatches.end(), [](const SPendingPatch& rkA, const SPendingPatch& rkB) {
+        return rkA.Offset < rkB.Offset;
+    });
+
+    for (const SPendingPatch& rkPatch : mPendingPatches)
+    {
+        if (!SyncFilePosition(rkPatch.Offset) || WriteToFile(&rkPatch.Data, rkPatch.Size, mpFStream, mUnlocked) != rkPatch.Size)
+        {
+            mWriteFailed = true;
+            break;
+        }
+
+        mFilePos += rkPatch.Size;
+        mSize = std::max(mSize, rkPatch.Offset + rkPatch.Size);
+    }
+
+    mPendingPatches.clear();
+    mPatchRangeStart = 0;
+    mPatchRangeEnd = 0;
+}
+
+bool CFileOutStream::SyncFilePosition(uint64_t Position)
+{
+    if (mFilePos == Position)
+        return true;
+
+#ifdef _WIN32
+    const bool Success = ((mUnlocked ? _fseeki64_nolock(mpFStream, Position, SEEK_SET) : _fseeki64(mpFStream, Position, SEEK_SET)) == 0);
+#else
+    const bool Success = (fseeko(mpFStream, Position, SEEK_SET) == 0);
+#endif
+
+    if (Success)
+        mFilePos = Position;
+
+    return Success;
+}
+
+bool CFileOutStream::SyncToDisk()
+{
+#ifdef _WIN32
+    return (_commit(_fileno(mpFStream)) == 0);
+#elif defined(__APPLE__)
+    // fsync on macOS only reaches the drive cache; F_FULLFSYNC asks the drive to flush it too
+    const int FileDesc = fileno(mpFStream);
+    return (fcntl(FileDesc, F_FULLFSYNC) == 0 || fsync(FileDesc) == 0);
+#else
+    return (fdatasync(fileno(mpFStream)) == 0);
+#endif
+}
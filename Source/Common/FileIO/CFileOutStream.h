@@ -1,18 +1,58 @@
 #ifndef AXIO_CFILEOUTSTREAM_H
 #define AXIO_CFILEOUTSTREAM_H
 
+#include "EFileAccessHint.h"
 #include "IOutputStream.h"
 
+#include <vector>
+
+// How hard Close() works to make sure the data actually reached the disk
+enum class EFileSyncPolicy
+{
+    None,           // Leave it to the OS
+    SyncOnClose,    // Flush file data to the storage device before closing
+    AtomicReplace   // Write to a temporary file, sync it, then rename it over the destination
+};
+
 class CFileOutStream : public IOutputStream
 {
 private:
     FILE *mpFStream = nullptr;
     TString mName;
-    uint32_t mSize = 0;
+    TString mTempName;
+    uint64_t mSize = 0;
+    uint64_t mPos = 0;              // Logical write position
+    uint64_t mFilePos = 0;          // Actual FILE position
+    EFileSyncPolicy mSyncPolicy = EFileSyncPolicy::None;
+    bool mWriteFailed = false;
+    bool mDropCacheOnFlush = false;
+    bool mUnlocked = false;         // Skip stdio locking; the stream is only used from one thread
+
+    // Optional user-space write buffer. When enabled, small writes are combined in memory and
+    // only reach the FILE once the buffer fills up, the stream seeks elsewhere, or is flushed.
+    std::vector<char> mBuffer;
+    uint64_t mBufferOffset = 0;     // File offset of mBuffer[0]
+    uint32_t mBufferFill = 0;       // Number of pending bytes in mBuffer
+
+    // Small patches are held here and written out in one pass on Flush() or Close(), so
+    // backpatching a header field doesn't cost a seek round trip every time. A write that
+    // overlaps the patched range applies them early so that the newer data still wins.
+    struct SPendingPatch
+    {
+        uint64_t Offset;
+        uint64_t Data;
+        uint32_t Size;
+    };
+    std::vector<SPendingPatch> mPendingPatches;
+    uint64_t mPatchRangeStart = 0;
+    uint64_t mPatchRangeEnd = 0;
 
 public:
+    static constexpr uint32_t skDefaultBufferSize = 0x40000;
+
     CFileOutStream();
-    explicit CFileOutStream(const TString& rkFile, std::endian FileEndianness);
+    explicit CFileOutStream(const TString& rkFile, std::endian FileEndianness, uint32_t BufferSize = 0,
+                            EFileSyncPolicy SyncPolicy = EFileSyncPolicy::None, bool Unlocked = false);
     ~CFileOutStream() override;
 
     CFileOutStream(const CFileOutStream&) = delete;
@@ -23,17 +63,47 @@ public:
 
     void Open(const TString& rkFile, std::endian);
     void Update(const TString& rkFile, std::endian FileEndianness);
-    void Close();
+    bool Close();
+    bool Flush();
+    void SetBufferSize(uint32_t BufferSize);
+    uint32_t BufferSize() const;
+    bool IsBuffered() const;
+    void SetSyncPolicy(EFileSyncPolicy Policy);
+    EFileSyncPolicy SyncPolicy() const;
+
+    /** Passes an access pattern hint for a range of the file on to the OS. Length 0 means to the end. */
+    bool SetAccessHint(EFileAccessHint Hint, uint64_t Offset = 0, uint64_t Length = 0);
+
+    /**
+     * When enabled, Flush() and Close() write the file's dirty pages back and evict them from the
+     * page cache. This keeps large one-off outputs from pushing everything else out of memory,
+     * at the cost of each flush waiting on the disk.
+     */
+    void SetDropCacheOnFlush(bool Enable);
+    bool DropsCacheOnFlush() const;
 
-    void WriteBytes(const void* pkSrc, uint32_t Count) override;
-    bool Seek(int32_t Offset, uint32_t Origin) override;
-    bool Seek64(int64_t Offset, uint32_t Origin) override;
-    uint32_t Tell() const override;
-    uint64_t Tell64() const override;
+    /**
+     * Stops stdio from locking the FILE on every write and seek. Only safe while the stream is
+     * used from a single thread, which is how streams are normally used anyway.
+     */
+    void SetUnlocked(bool Unlocked);
+    bool IsUnlocked() const;
+
+    void WriteBytes(const void* pkSrc, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
     bool EoF() const override;
     bool IsValid() const override;
-    uint32_t Size() const override;
+    uint64_t Size() const override;
+    void PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count) override;
+    void WriteGather(std::span<const std::span<const uint8_t>> Buffers) override;
     TString FileName() const;
+
+private:
+    bool FlushBuffer();
+    void ApplyPendingPatches();
+    bool SyncFilePosition(uint64_t Position);
+    bool SyncToDisk();
 };
 
 #endif // AXIO_CFILEOUTSTREAM_H
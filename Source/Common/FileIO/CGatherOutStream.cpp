@@ -0,0 +1,255 @@
+#include "CGatherOutStream.h"
+
+#include "Common/Macros.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+CGatherOutStream::CGatherOutStream()
+{
+    mDataEndianness = std::endian::big;
+}
+
+CGatherOutStream::CGatherOutStream(std::endian DataEndianness)
+{
+    mDataEndianness = DataEndianness;
+}
+
+CGatherOutStream::~CGatherOutStream() = default;
+
+void CGatherOutStream::WriteBytes(const void *pkSrc, size_t Count)
+{
+    const auto *pkBytes = static_cast<const uint8_t*>(pkSrc);
+
+    // Overwrite whatever overlaps the existing data, then append the rest
+    if (mPos < mSize)
+    {
+        const auto NumOverlap = static_cast<size_t>(std::min<uint64_t>(Count, mSize - mPos));
+        PatchBytes(mPos, pkBytes, NumOverlap);
+        mPos += NumOverlap;
+        pkBytes += NumOverlap;
+        Count -= NumOverlap;
+    }
+
+    if (Count == 0)
+        return;
+
+    if (Count <= skInlineThreshold)
+    {
+        AppendInline(pkBytes, Count);
+    }
+    else
+    {
+        mStorage.emplace_back(pkBytes, pkBytes + Count);
+        Append(mStorage.back().data(), Count, static_cast<uint32_t>(mStorage.size() - 1));
+    }
+
+    mPos = mSize;
+}
+
+bool CGatherOutStream::Seek(int64_t Offset, uint32_t Origin)
+{
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mSize) - Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < 0)
+        return false;
+
+    // Seeking past the end behaves like a file; the gap reads back as zeroes
+    if (static_cast<uint64_t>(NewPos) > mSize)
+        AppendZeroes(static_cast<size_t>(NewPos - mSize));
+
+    mPos = static_cast<uint64_t>(NewPos);
+    return true;
+}
+
+uint64_t CGatherOutStream::Tell() const
+{
+    return mPos;
+}
+
+bool CGatherOutStream::EoF() const
+{
+    return false;
+}
+
+bool CGatherOutStream::IsValid() const
+{
+    return true;
+}
+
+uint64_t CGatherOutStream::Size() const
+{
+    return mSize;
+}
+
+void CGatherOutStream::PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count)
+{
+    if (Count == 0)
+        return;
+
+    // Patches that extend past the current data need the usual growth handling
+    if (Offset + Count > mSize)
+    {
+        IOutputStream::PatchBytes(Offset, pkSrc, Count);
+        return;
+    }
+
+    const auto *pkBytes = static_cast<const uint8_t*>(pkSrc);
+    auto Iter = std::upper_bound(mChunks.begin(), mChunks.end(), Offset, [](uint64_t Offset, const SChunk& rkChunk) {
+        return Offset < rkChunk.Offset;
+    });
+
+    for (--Iter; Count > 0; ++Iter)
+    {
+        SChunk& rChunk = *Iter;
+
+        // Borrowed data belongs to the caller, so take a private copy of the chunk before changing it
+        if (rChunk.StorageIdx == skBorrowed)
+        {
+            mStorage.emplace_back(rChunk.pkData, rChunk.pkData + rChunk.Size);
+            rChunk.pkData = mStorage.back().data();
+            rChunk.StorageIdx = static_cast<uint32_t>(mStorage.size() - 1);
+        }
+
+        const auto ChunkOffset = static_cast<size_t>(Offset - rChunk.Offset);
+        const size_t NumToCopy = std::min(Count, rChunk.Size - ChunkOffset);
+
+        // Owned chunks point into mStorage, which we're free to modify
+        std::memcpy(const_cast<uint8_t*>(rChunk.pkData) + ChunkOffset, pkBytes, NumToCopy);
+        Offset += NumToCopy;
+        pkBytes += NumToCopy;
+        Count -= NumToCopy;
+    }
+}
+
+void CGatherOutStream::WriteBorrowed(std::span<const uint8_t> Data)
+{
+    // Small pieces aren't worth a chunk of their own, and overwrites have to go through a copy
+    if (Data.size() <= skInlineThreshold || mPos < mSize)
+    {
+        WriteBytes(Data.data(), Data.size());
+        return;
+    }
+
+    Append(Data.data(), Data.size(), skBorrowed);
+    mPos = mSize;
+}
+
+void CGatherOutStream::WriteOwned(std::vector<uint8_t>&& rrData)
+{
+    if (rrData.size() <= skInlineThreshold || mPos < mSize)
+    {
+        WriteBytes(rrData.data(), rrData.size());
+        return;
+    }
+
+    mStorage.push_back(std::move(rrData));
+    Append(mStorage.back().data(), mStorage.back().size(), static_cast<uint32_t>(mStorage.size() - 1));
+    mPos = mSize;
+}
+
+void CGatherOutStream::WriteTo(IOutputStream& rDest) const
+{
+    std::vector<std::span<const uint8_t>> Buffers;
+    Buffers.reserve(mChunks.size());
+
+    for (const SChunk& rkChunk : mChunks)
+        Buffers.emplace_back(rkChunk.pkData, rkChunk.Size);
+
+    rDest.WriteGather(Buffers);
+}
+
+void CGatherOutStream::CopyTo(std::span<uint8_t> Dst) const
+{
+    ASSERT(Dst.size() >= mSize);
+
+    for (const SChunk& rkChunk : mChunks)
+        std::memcpy(Dst.data() + rkChunk.Offset, rkChunk.pkData, rkChunk.Size);
+}
+
+std::vector<uint8_t> CGatherOutStream::Flatten() const
+{
+    std::vector<uint8_t> Out(static_cast<size_t>(mSize));
+    CopyTo(Out);
+    return Out;
+}
+
+size_t CGatherOutStream::NumChunks() const
+{
+    return mChunks.size();
+}
+
+void CGatherOutStream::Clear()
+{
+    mChunks.clear();
+    mStorage.clear();
+    mInlineStorageIdx = skBorrowed;
+    mSize = 0;
+    mPos = 0;
+}
+
+// ************ PRIVATE ************
+void CGatherOutStream::Append(const uint8_t *pkData, size_t Size, uint32_t StorageIdx)
+{
+    mChunks.push_back(SChunk{mSize, pkData, Size, StorageIdx});
+    mSize += Size;
+}
+
+void CGatherOutStream::AppendInline(const uint8_t *pkSrc, size_t Count)
+{
+    // Inline blocks never reallocate, since chunks point into them
+    if (mInlineStorageIdx == skBorrowed || mStorage[mInlineStorageIdx].capacity() - mStorage[mInlineStorageIdx].size() < Count)
+    {
+        mStorage.emplace_back().reserve(skInlineBlockSize);
+        mInlineStorageIdx = static_cast<uint32_t>(mStorage.size() - 1);
+    }
+
+    std::vector<uint8_t>& rBlock = mStorage[mInlineStorageIdx];
+    const uint8_t *pkDst = rBlock.data() + rBlock.size();
+    rBlock.insert(rBlock.end(), pkSrc, pkSrc + Count);
+
+    // Consecutive small writes extend the same chunk
+    if (!mChunks.empty() && mChunks.back().StorageIdx == mInlineStorageIdx && mChunks.back().pkData + mChunks.back().Size == pkDst)
+    {
+        mChunks.back().Size += Count;
+        mSize += Count;
+    }
+    else
+    {
+        Append(pkDst, Count, mInlineStorageIdx);
+    }
+}
+
+void CGatherOutStream::AppendZeroes(size_t Count)
+{
+    static constexpr uint8_t skZeroes[skInlineThreshold] = {};
+
+    if (Count <= skInlineThreshold)
+    {
+        AppendInline(skZeroes, Count);
+    }
+    else
+    {
+        mStorage.emplace_back(Count, 0);
+        Append(mStorage.back().data(), Count, static_cast<uint32_t>(mStorage.size() - 1));
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef AXIO_CGATHEROUTSTREAM_H
+#define AXIO_CGATHEROUTSTREAM_H
+
+#include "IOutputStream.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Builds output as a list of chunks rather than one contiguous buffer, for assembling files
+// out of large blobs that already exist in memory. Borrowed chunks are referenced in place and
+// must stay alive until the stream is flushed or cleared; owned chunks are moved in without a
+// copy. Small writes are copied into shared inline blocks so they don't each cost a chunk.
+// WriteTo() hands the whole list to the destination at once, which file streams turn into writev.
+class CGatherOutStream : public IOutputStream
+{
+    struct SChunk
+    {
+        uint64_t Offset;
+        const uint8_t *pkData;
+        size_t Size;
+        uint32_t StorageIdx;    // Index into mStorage, or skBorrowed
+    };
+
+    std::vector<SChunk> mChunks;
+    std::vector<std::vector<uint8_t>> mStorage;
+    uint32_t mInlineStorageIdx = skBorrowed;
+    uint64_t mSize = 0;
+    uint64_t mPos = 0;
+
+    static constexpr uint32_t skBorrowed = UINT32_MAX;
+
+public:
+    static constexpr uint32_t skInlineThreshold = 0x200;
+    static constexpr uint32_t skInlineBlockSize = 0x10000;
+
+    CGatherOutStream();
+    explicit CGatherOutStream(std::endian DataEndianness);
+    ~CGatherOutStream() override;
+
+    void WriteBytes(const void* pkSrc, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
+    bool EoF() const override;
+    bool IsValid() const override;
+    uint64_t Size() const override;
+    void PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count) override;
+
+    /** Appends data by reference. It must outlive the stream, or at least the next WriteTo/Clear. */
+    void WriteBorrowed(std::span<const uint8_t> Data);
+    /** Appends a buffer, taking ownership of it */
+    void WriteOwned(std::vector<uint8_t>&& rrData);
+
+    /** Writes every chunk to rDest in order, in a single WriteGather call */
+    void WriteTo(IOutputStream& rDest) const;
+    /** Copies the contents into Dst, which must hold at least Size() bytes */
+    void CopyTo(std::span<uint8_t> Dst) const;
+    std::vector<uint8_t> Flatten() const;
+
+    size_t NumChunks() const;
+    void Clear();
+
+private:
+    void Append(const uint8_t *pkData, size_t Size, uint32_t StorageIdx);
+    void AppendInline(const uint8_t *pkSrc, size_t Count);
+    void AppendZeroes(size_t Count);
+};
+
+#endif // AXIO_CGATHEROUTSTREAM_H
@@ -0,0 +1,312 @@
+#include "CInflateInStream.h"
+
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <limits>
+#include <zlib.h>
+
+namespace
+{
+
+// zlib counts bytes in uInt, so anything larger has to be fed to it in pieces
+constexpr size_t kMaxZlibChunk = std::numeric_limits<uInt>::max();
+
+// Window bits for inflateInit2; adding 32 enables automatic zlib/gzip header detection
+constexpr int kAutoDetectWindowBits = 15 + 32;
+
+} // anonymous namespace
+
+CInflateInStream::CInflateInStream() = default;
+
+CInflateInStream::CInflateInStream(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize)
+{
+    Open(pSource, CompressedSize, DecompressedSize);
+}
+
+CInflateInStream::~CInflateInStream()
+{
+    Close();
+}
+
+void CInflateInStream::Open(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize)
+{
+    Close();
+
+    if (!pSource || !pSource->IsValid())
+        return;
+
+    mDataEndianness = pSource->GetEndianness();
+    SetSourceString(pSource->GetSourceString());
+
+    mpZStream = std::make_unique<z_stream>();
+
+    if (inflateInit2(mpZStream.get(), kAutoDetectWindowBits) != Z_OK)
+    {
+        NLog::Error("{}: Failed to initialize zlib decompression", mDataSource);
+        mpZStream.reset();
+        return;
+    }
+
+    mpSource = pSource;
+    mSourceStart = pSource->Tell();
+    mSourcePos = mSourceStart;
+    mSourceEnd = mSourceStart + CompressedSize;
+    mDecompressedSize = DecompressedSize;
+    mPos = 0;
+    mStreamEnd = false;
+    mError = false;
+}
+
+void CInflateInStream::Close()
+{
+    if (mpZStream)
+    {
+        inflateEnd(mpZStream.get());
+        mpZStream.reset();
+    }
+
+    mpSource = nullptr;
+    mSourceStart = 0;
+    mSourcePos = 0;
+    mSourceEnd = 0;
+    mDecompressedSize = 0;
+    mPos = 0;
+    mStreamEnd = false;
+    mError = false;
+}
+
+void CInflateInStream::ReadBytes(void *pDst, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    Count = static_cast<size_t>(std::min<uint64_t>(Count, mDecompressedSize - mPos));
+    mPos += Inflate(static_cast<uint8_t*>(pDst), Count);
+}
+
+bool CInflateInStream::Seek(int64_t Offset, uint32_t Origin)
+{
+    if (!IsValid())
+        return false;
+
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mDecompressedSize) + Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < 0 || static_cast<uint64_t>(NewPos) > mDecompressedSize)
+        return false;
+
+    // There's no way to step a deflate stream backward; start over and skip forward instead
+    if (static_cast<uint64_t>(NewPos) < mPos)
+        Restart();
+
+    uint8_t Discard[0x1000];
+
+    while (mPos < static_cast<uint64_t>(NewPos))
+    {
+        const auto NumBytes = static_cast<size_t>(std::min<uint64_t>(sizeof(Discard), NewPos - mPos));
+        const size_t NumInflated = Inflate(Discard, NumBytes);
+        mPos += NumInflated;
+
+        if (NumInflated < NumBytes)
+            return false;
+    }
+
+    return true;
+}
+
+uint64_t CInflateInStream::Tell() const
+{
+    return mPos;
+}
+
+bool CInflateInStream::EoF() const
+{
+    return mStreamEnd || mError || mPos >= mDecompressedSize;
+}
+
+bool CInflateInStream::IsValid() const
+{
+    return mpZStream != nullptr && mpSource->IsValid();
+}
+
+uint64_t CInflateInStream::Size() const
+{
+    return mDecompressedSize;
+}
+
+bool CInflateInStream::Decompress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize)
+{
+    rOutSize = 0;
+    z_stream ZStream{};
+
+    if (inflateInit2(&ZStream, kAutoDetectWindowBits) != Z_OK)
+        return false;
+
+    ZStream.next_in = const_cast<Bytef*>(Src.data());
+    ZStream.next_out = Dst.data();
+    int Result = Z_OK;
+
+    while (Result == Z_OK)
+    {
+        const size_t InRemaining = Src.size() - (ZStream.next_in - Src.data());
+        const size_t OutRemaining = Dst.size() - (ZStream.next_out - Dst.data());
+
+        if (ZStream.avail_in == 0)
+            ZStream.avail_in = static_cast<uInt>(std::min(InRemaining, kMaxZlibChunk));
+        if (ZStream.avail_out == 0)
+            ZStream.avail_out = static_cast<uInt>(std::min(OutRemaining, kMaxZlibChunk));
+
+        Result = inflate(&ZStream, Z_NO_FLUSH);
+    }
+
+    rOutSize = static_cast<size_t>(ZStream.next_out - Dst.data());
+    inflateEnd(&ZStream);
+    return (Result == Z_STREAM_END);
+}
+
+bool CInflateInStream::Decompress(IInputStream& rSource, uint64_t CompressedSize, std::span<uint8_t> Dst, size_t& rOutSize)
+{
+    // If the compressed data is already in memory, inflate it in place
+    size_t NumBuffered = 0;
+    const void* pkBuffered = rSource.BufferedDataAtPosition(NumBuffered);
+
+    if (pkBuffered && NumBuffered >= CompressedSize)
+    {
+        const bool Success = Decompress({static_cast<const uint8_t*>(pkBuffered), static_cast<size_t>(CompressedSize)}, Dst, rOutSize);
+        rSource.Skip(static_cast<int64_t>(CompressedSize));
+        return Success;
+    }
+
+    const uint64_t End = rSource.Tell() + CompressedSize;
+    CInflateInStream Stream(&rSource, CompressedSize, Dst.size());
+
+    if (!Stream.IsValid())
+    {
+        rOutSize = 0;
+        return false;
+    }
+
+    Stream.ReadBytes(Dst.data(), Dst.size());
+    rOutSize = static_cast<size_t>(Stream.Tell());
+
+    // An exactly-sized Dst leaves the end-of-stream marker unread; check that nothing follows
+    uint8_t Extra;
+    const bool Success = (Stream.Inflate(&Extra, 1) == 0 && Stream.mStreamEnd);
+    rSource.GoTo(End);
+    return Success;
+}
+
+// ************ PRIVATE ************
+void CInflateInStream::Restart()
+{
+    inflateReset(mpZStream.get());
+    mpZStream->avail_in = 0;
+    mSourcePos = mSourceStart;
+    mPos = 0;
+    mStreamEnd = false;
+    mError = false;
+}
+
+size_t CInflateInStream::Inflate(uint8_t *pDst, size_t Count)
+{
+    z_stream& rZStream = *mpZStream;
+    size_t NumProduced = 0;
+
+    while (NumProduced < Count && !mStreamEnd && !mError)
+    {
+        bool InputIsBorrowed = false;
+
+        if (rZStream.avail_in == 0)
+        {
+            const uint64_t NumRemaining = mSourceEnd - mSourcePos;
+
+            if (NumRemaining == 0)
+            {
+                NLog::Error("{}: Compressed data ended before the end of the stream", mDataSource);
+                mError = true;
+                break;
+            }
+
+            // Only reposition the source if something else moved it since our last read
+            if (mpSource->Tell() != mSourcePos)
+                mpSource->GoTo(mSourcePos);
+
+            size_t NumBuffered = 0;
+            const void* pkBuffered = mpSource->BufferedDataAtPosition(NumBuffered);
+
+            if (pkBuffered && NumBuffered > 0)
+            {
+                rZStream.next_in = static_cast<Bytef*>(const_cast<void*>(pkBuffered));
+                rZStream.avail_in = static_cast<uInt>(std::min<uint64_t>({NumBuffered, NumRemaining, kMaxZlibChunk}));
+                InputIsBorrowed = true;
+            }
+            else
+            {
+                if (mInputBuffer.empty())
+                    mInputBuffer.resize(skInputBufferSize);
+
+                const auto NumToRead = static_cast<size_t>(std::min<uint64_t>(mInputBuffer.size(), NumRemaining));
+                mpSource->ReadBytes(mInputBuffer.data(), NumToRead);
+                const uint64_t NumRead = mpSource->Tell() - mSourcePos;
+
+                if (NumRead == 0)
+                {
+                    NLog::Error("{}: Unexpected end of compressed data", mDataSource);
+                    mError = true;
+                    break;
+                }
+
+                mSourcePos += NumRead;
+                rZStream.next_in = mInputBuffer.data();
+                rZStream.avail_in = static_cast<uInt>(NumRead);
+            }
+        }
+
+        const uInt AvailIn = rZStream.avail_in;
+        const uInt AvailOut = static_cast<uInt>(std::min(Count - NumProduced, kMaxZlibChunk));
+        rZStream.next_out = pDst + NumProduced;
+        rZStream.avail_out = AvailOut;
+
+        const int Result = inflate(&rZStream, Z_NO_FLUSH);
+        NumProduced += AvailOut - rZStream.avail_out;
+
+        // Borrowed input is only valid until the source moves, so hand back whatever wasn't used
+        if (InputIsBorrowed)
+        {
+            const uInt NumConsumed = AvailIn - rZStream.avail_in;
+            mpSource->Skip(NumConsumed);
+            mSourcePos += NumConsumed;
+            rZStream.avail_in = 0;
+        }
+
+        if (Result == Z_STREAM_END)
+        {
+            mStreamEnd = true;
+        }
+        else if (Result != Z_OK && Result != Z_BUF_ERROR)
+        {
+            NLog::Error("{}: zlib decompression failed: {}", mDataSource, rZStream.msg ? rZStream.msg : "unknown error");
+            mError = true;
+        }
+    }
+
+    return NumProduced;
+}
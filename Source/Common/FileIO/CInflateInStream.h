@@ -0,0 +1,68 @@
+#ifndef AXIO_CINFLATEINSTREAM_H
+#define AXIO_CINFLATEINSTREAM_H
+
+#include "IInputStream.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+struct z_stream_s;
+
+// Decompresses a zlib (or gzip) stream on the fly from [Offset, Offset + CompressedSize) of
+// another input stream. Data is inflated straight into the caller's destination buffer, and if
+// the source already has the compressed bytes in memory (memory/mapped/buffered streams) they're
+// consumed in place rather than copied into a staging buffer first.
+// Seeking forward decompresses and discards; seeking backward restarts from the beginning.
+class CInflateInStream : public IInputStream
+{
+    IInputStream *mpSource = nullptr;
+    uint64_t mSourceStart = 0;
+    uint64_t mSourcePos = 0;
+    uint64_t mSourceEnd = 0;
+    uint64_t mDecompressedSize = 0;
+    uint64_t mPos = 0;
+
+    std::unique_ptr<z_stream_s> mpZStream;
+    std::vector<uint8_t> mInputBuffer;
+    bool mStreamEnd = false;
+    bool mError = false;
+
+public:
+    static constexpr uint32_t skInputBufferSize = 0x10000;
+
+    CInflateInStream();
+    explicit CInflateInStream(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize);
+    ~CInflateInStream() override;
+
+    CInflateInStream(const CInflateInStream&) = delete;
+    CInflateInStream& operator=(const CInflateInStream&) = delete;
+
+    /** Starts decompressing from the source stream's current position */
+    void Open(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize);
+    void Close();
+
+    void ReadBytes(void* pDst, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
+    bool EoF() const override;
+    bool IsValid() const override;
+    uint64_t Size() const override;
+
+    /**
+     * Decompresses a complete zlib stream from Src into Dst in a single pass.
+     * rOutSize receives the number of bytes written. Returns false on corrupt input or if
+     * Dst is too small to hold the decompressed data.
+     */
+    static bool Decompress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize);
+
+    /** Decompresses CompressedSize bytes from the stream's current position into Dst */
+    static bool Decompress(IInputStream& rSource, uint64_t CompressedSize, std::span<uint8_t> Dst, size_t& rOutSize);
+
+private:
+    void Restart();
+    size_t Inflate(uint8_t *pDst, size_t Count);
+};
+
+#endif // AXIO_CINFLATEINSTREAM_H
@@ -0,0 +1,654 @@
+#include "CLZOInStream.h"
+#include "CInflateInStream.h"
+
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+
+struct SSegment
+{
+    size_t SrcOffset;
+    size_t SrcSize;
+    size_t DstOffset;
+    size_t DstSize;
+    bool IsCompressed;
+};
+
+// Reads the big-endian int16 size that precedes each segment
+int32_t ReadSegmentHeader(const uint8_t *pkHeader)
+{
+    return static_cast<int16_t>((pkHeader[0] << 8) | pkHeader[1]);
+}
+
+// Decodes LZO1X as specified by the reference lzo1x_decompress_safe: every read, write and
+// match distance is bounds checked, so corrupt data fails cleanly instead of overrunning.
+class CLZO1XDecoder
+{
+    enum class EState
+    {
+        Top,            // The next instruction may be a literal run
+        AfterLiterals,  // Just copied a literal run of 4+ bytes
+        AfterTrailing   // Just copied 1-3 literals that trailed a match
+    };
+
+    const uint8_t *mpkSrc;
+    size_t mSrcSize;
+    size_t mIn = 0;
+    uint8_t *mpDst;
+    size_t mDstSize;
+    size_t mOut = 0;
+
+public:
+    CLZO1XDecoder(std::span<const uint8_t> Src, std::span<uint8_t> Dst)
+        : mpkSrc(Src.data()), mSrcSize(Src.size()), mpDst(Dst.data()), mDstSize(Dst.size())
+    {}
+
+    size_t NumDecoded() const { return mOut; }
+
+    bool Decode()
+    {
+        if (mSrcSize == 0)
+            return false;
+
+        EState State = EState::Top;
+
+        // A first byte above 17 is a literal run with no instruction preceding it
+        if (mpkSrc[0] > 17)
+        {
+            const size_t NumLiterals = mpkSrc[mIn++] - 17;
+
+            if (!CopyLiterals(NumLiterals))
+                return false;
+
+            State = (NumLiterals < 4 ? EState::AfterTrailing : EState::AfterLiterals);
+        }
+
+        while (true)
+        {
+            if (mIn >= mSrcSize)
+                return false;
+
+            const size_t Inst = mpkSrc[mIn++];
+            size_t Dist;
+            size_t Len;
+
+            if (Inst < 16)
+            {
+                if (State == EState::Top)
+                {
+                    size_t NumLiterals = Inst;
+
+                    if (NumLiterals == 0 && !ReadLength(15, NumLiterals))
+                        return false;
+                    if (!CopyLiterals(NumLiterals + 3))
+                        return false;
+
+                    State = EState::AfterLiterals;
+                    continue;
+                }
+
+                // M1: a short match whose meaning depends on what came before it
+                if (mIn >= mSrcSize)
+                    return false;
+
+                const size_t Next = mpkSrc[mIn++];
+
+                if (State == EState::AfterLiterals)
+                {
+                    Dist = 1 + 0x800 + (Inst >> 2) + (Next << 2);
+                    Len = 3;
+                }
+                else
+                {
+                    Dist = 1 + (Inst >> 2) + (Next << 2);
+                    Len = 2;
+                }
+            }
+            else if (Inst >= 64)
+            {
+                // M2: 3-8 bytes, up to 2KB back
+                if (mIn >= mSrcSize)
+                    return false;
+
+                Dist = 1 + ((Inst >> 2) & 7) + (mpkSrc[mIn++] << 3);
+                Len = (Inst >> 5) + 1;
+            }
+            else if (Inst >= 32)
+            {
+                // M3: up to 16KB back
+                Len = Inst & 31;
+
+                if (Len == 0 && !ReadLength(31, Len))
+                    return false;
+                if (mSrcSize - mIn < 2)
+                    return false;
+
+                Dist = 1 + (ReadLE16() >> 2);
+                Len += 2;
+            }
+            else
+            {
+                // M4: 16-48KB back, or the end of the stream if the distance is zero
+                Dist = (Inst & 8) << 11;
+                Len = Inst & 7;
+
+                if (Len == 0 && !ReadLength(7, Len))
+                    return false;
+                if (mSrcSize - mIn < 2)
+                    return false;
+
+                Dist += ReadLE16() >> 2;
+                Len += 2;
+
+                if (Dist == 0)
+                    return (mIn == mSrcSize);
+
+                Dist += 0x4000;
+            }
+
+            if (!CopyMatch(Dist, Len))
+                return false;
+
+            // The low two bits of the byte before last hold the number of literals trailing the match
+            const size_t NumTrailing = mpkSrc[mIn - 2] & 3;
+
+            if (NumTrailing == 0)
+            {
+                State = EState::Top;
+            }
+            else
+            {
+                if (!CopyLiterals(NumTrailing))
+                    return false;
+
+                State = EState::AfterTrailing;
+            }
+        }
+    }
+
+private:
+    size_t ReadLE16()
+    {
+        const size_t Value = mpkSrc[mIn] | (mpkSrc[mIn + 1] << 8);
+        mIn += 2;
+        return Value;
+    }
+
+    // Long lengths are encoded as a run of zero bytes (255 each) followed by a non-zero byte
+    bool ReadLength(size_t Base, size_t& rLen)
+    {
+        size_t Len = Base;
+
+        while (mIn < mSrcSize)
+        {
+            const uint8_t Byte = mpkSrc[mIn++];
+
+            if (Byte != 0)
+            {
+                rLen = Len + Byte;
+                return true;
+            }
+
+            Len += 255;
+
+            if (Len > mDstSize)
+                return false;
+        }
+
+        return false;
+    }
+
+    bool CopyLiterals(size_t Count)
+    {
+        if (mSrcSize - mIn < Count || mDstSize - mOut < Count)
+            return false;
+
+        std::memcpy(mpDst + mOut, mpkSrc + mIn, Count);
+        mIn += Count;
+        mOut += Count;
+        return true;
+    }
+
+    bool CopyMatch(size_t Dist, size_t Len)
+    {
+        if (Dist > mOut || mDstSize - mOut < Len)
+            return false;
+
+        uint8_t *pOut = mpDst + mOut;
+        mOut += Len;
+
+        if (Dist >= Len)
+        {
+            std::memcpy(pOut, pOut - Dist, Len);
+            return true;
+        }
+
+        // Overlapping match: the output repeats with period Dist, so each pass can copy
+        // everything written so far, doubling the chunk size instead of going byte by byte
+        size_t Done = 0;
+
+        for (size_t Period = Dist; Done < Len; Period *= 2)
+        {
+            const size_t Chunk = std::min(Period, Len - Done);
+            std::memcpy(pOut + Done, pOut + Done - Period, Chunk);
+            Done += Chunk;
+        }
+
+        return true;
+    }
+};
+
+// Segment payloads are usually LZO, but some files store them with zlib instead
+bool DecodeSegment(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize)
+{
+    const bool LooksLikeZlib = Src.size() >= 2 && (Src[0] & 0xF) == 8 && ((Src[0] << 8) | Src[1]) % 31 == 0;
+
+    if (LooksLikeZlib && CInflateInStream::Decompress(Src, Dst, rOutSize))
+        return true;
+
+    return CLZOInStream::DecompressLZO1X(Src, Dst, rOutSize);
+}
+
+// Walks the segment headers to find where each segment's output goes. This assumes every
+// compressed segment fills a whole skSegmentSize block, which is how the games write them.
+bool ScanSegments(std::span<const uint8_t> Src, size_t DstSize, std::vector<SSegment>& rSegments)
+{
+    size_t SrcPos = 0;
+    size_t DstPos = 0;
+
+    while (DstPos < DstSize)
+    {
+        if (Src.size() - SrcPos < 2)
+            return false;
+
+        const int32_t Size = ReadSegmentHeader(&Src[SrcPos]);
+        SSegment& rSegment = rSegments.emplace_back();
+        rSegment.SrcOffset = SrcPos + 2;
+        rSegment.SrcSize = static_cast<size_t>(Size < 0 ? -Size : Size);
+        rSegment.DstOffset = DstPos;
+        rSegment.DstSize = (Size < 0 ? rSegment.SrcSize : std::min<size_t>(CLZOInStream::skSegmentSize, DstSize - DstPos));
+        rSegment.IsCompressed = (Size > 0);
+
+        if (Size == 0 || Src.size() - rSegment.SrcOffset < rSegment.SrcSize || DstSize - DstPos < rSegment.DstSize)
+            return false;
+
+        SrcPos = rSegment.SrcOffset + rSegment.SrcSize;
+        DstPos += rSegment.DstSize;
+    }
+
+    return true;
+}
+
+bool DecompressSequential(std::span<const uint8_t> Src, std::span<uint8_t> Dst)
+{
+    size_t SrcPos = 0;
+    size_t DstPos = 0;
+
+    // The source may be padded past the last segment, so stop once the output is full
+    while (DstPos < Dst.size())
+    {
+        if (Src.size() - SrcPos < 2)
+            return false;
+
+        const int32_t Size = ReadSegmentHeader(&Src[SrcPos]);
+        const auto PayloadSize = static_cast<size_t>(Size < 0 ? -Size : Size);
+        SrcPos += 2;
+
+        if (Size == 0 || Src.size() - SrcPos < PayloadSize)
+            return false;
+
+        const std::span<const uint8_t> Payload = Src.subspan(SrcPos, PayloadSize);
+        const std::span<uint8_t> Out = Dst.subspan(DstPos);
+        size_t OutSize;
+
+        if (Size < 0)
+        {
+            if (Out.size() < PayloadSize)
+                return false;
+
+            std::memcpy(Out.data(), Payload.data(), PayloadSize);
+            OutSize = PayloadSize;
+        }
+        else if (!DecodeSegment(Payload, Out.first(std::min<size_t>(CLZOInStream::skSegmentSize, Out.size())), OutSize) || OutSize == 0)
+        {
+            return false;
+        }
+
+        SrcPos += PayloadSize;
+        DstPos += OutSize;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+CLZOInStream::CLZOInStream() = default;
+
+CLZOInStream::CLZOInStream(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize)
+{
+    Open(pSource, CompressedSize, DecompressedSize);
+}
+
+CLZOInStream::~CLZOInStream() = default;
+
+void CLZOInStream::Open(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize)
+{
+    Close();
+
+    if (!pSource || !pSource->IsValid())
+        return;
+
+    mDataEndianness = pSource->GetEndianness();
+    SetSourceString(pSource->GetSourceString());
+
+    mpSource = pSource;
+    mSourceStart = pSource->Tell();
+    mSourceEnd = mSourceStart + CompressedSize;
+    mDecompressedSize = DecompressedSize;
+    Restart();
+}
+
+void CLZOInStream::Close()
+{
+    mpSource = nullptr;
+    mSourceStart = 0;
+    mSourceEnd = 0;
+    mDecompressedSize = 0;
+    Restart();
+}
+
+void CLZOInStream::ReadBytes(void *pDst, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    auto *pOut = static_cast<uint8_t*>(pDst);
+    Count = static_cast<size_t>(std::min<uint64_t>(Count, mDecompressedSize - mPos));
+
+    while (Count > 0 && !mError)
+    {
+        // Serve what we can from the last segment that was decoded into the internal buffer
+        if (mPos >= mSegmentPos && mPos < mSegmentPos + mSegmentFill)
+        {
+            const auto Offset = static_cast<size_t>(mPos - mSegmentPos);
+            const size_t NumToCopy = std::min<size_t>(Count, mSegmentFill - Offset);
+            std::memcpy(pOut, &mSegment[Offset], NumToCopy);
+            pOut += NumToCopy;
+            Count -= NumToCopy;
+            mPos += NumToCopy;
+            continue;
+        }
+
+        size_t NumDecoded;
+
+        if (!DecodeNextSegment(pOut, Count, NumDecoded))
+            break;
+
+        // The segment went straight to the caller if it fit, otherwise it's now buffered
+        if (mSegmentFill == 0)
+        {
+            pOut += NumDecoded;
+            Count -= NumDecoded;
+            mPos += NumDecoded;
+        }
+    }
+}
+
+bool CLZOInStream::Seek(int64_t Offset, uint32_t Origin)
+{
+    if (!IsValid())
+        return false;
+
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mDecompressedSize) + Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < 0 || static_cast<uint64_t>(NewPos) > mDecompressedSize)
+        return false;
+
+    const auto Target = static_cast<uint64_t>(NewPos);
+    const bool InBufferedSegment = (Target >= mSegmentPos && Target < mSegmentPos + mSegmentFill);
+
+    // Segment boundaries aren't known ahead of time, so seeking backward starts over
+    if (Target < mNextSegmentPos && !InBufferedSegment)
+        Restart();
+
+    while (Target > mNextSegmentPos && !mError)
+    {
+        size_t NumDecoded;
+
+        if (!DecodeNextSegment(nullptr, 0, NumDecoded))
+            return false;
+    }
+
+    mPos = Target;
+    return true;
+}
+
+uint64_t CLZOInStream::Tell() const
+{
+    return mPos;
+}
+
+bool CLZOInStream::EoF() const
+{
+    return mError || mPos >= mDecompressedSize;
+}
+
+bool CLZOInStream::IsValid() const
+{
+    return mpSource != nullptr && mpSource->IsValid();
+}
+
+uint64_t CLZOInStream::Size() const
+{
+    return mDecompressedSize;
+}
+
+bool CLZOInStream::DecompressLZO1X(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize)
+{
+    CLZO1XDecoder Decoder(Src, Dst);
+    const bool Success = Decoder.Decode();
+    rOutSize = Decoder.NumDecoded();
+    return Success;
+}
+
+bool CLZOInStream::Decompress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, uint32_t NumThreads)
+{
+    if (NumThreads == 0)
+        NumThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<SSegment> Segments;
+
+    if (NumThreads == 1 || !ScanSegments(Src, Dst.size(), Segments) || Segments.size() < 2)
+        return DecompressSequential(Src, Dst);
+
+    std::atomic<size_t> NextSegment = 0;
+    std::atomic<bool> Failed = false;
+
+    auto DecodeSegments = [&]()
+    {
+        size_t Index;
+
+        while (!Failed && (Index = NextSegment++) < Segments.size())
+        {
+            const SSegment& rkSegment = Segments[Index];
+            const std::span<const uint8_t> Payload = Src.subspan(rkSegment.SrcOffset, rkSegment.SrcSize);
+            const std::span<uint8_t> Out = Dst.subspan(rkSegment.DstOffset, rkSegment.DstSize);
+
+            if (!rkSegment.IsCompressed)
+            {
+                std::memcpy(Out.data(), Payload.data(), Payload.size());
+                continue;
+            }
+
+            size_t OutSize;
+
+            if (!DecodeSegment(Payload, Out, OutSize) || OutSize != Out.size())
+                Failed = true;
+        }
+    };
+
+    const size_t NumWorkers = std::min<size_t>(NumThreads, Segments.size()) - 1;
+    std::vector<std::thread> Workers;
+    Workers.reserve(NumWorkers);
+
+    for (size_t WorkerIdx = 0; WorkerIdx < NumWorkers; WorkerIdx++)
+        Workers.emplace_back(DecodeSegments);
+
+    DecodeSegments();
+
+    for (std::thread& rWorker : Workers)
+        rWorker.join();
+
+    // A compressed segment that didn't fill a whole block throws off the precomputed offsets;
+    // the sequential path places each segment after the actual end of the previous one
+    return !Failed || DecompressSequential(Src, Dst);
+}
+
+bool CLZOInStream::Decompress(IInputStream& rSource, uint64_t CompressedSize, std::span<uint8_t> Dst, uint32_t NumThreads)
+{
+    size_t NumBuffered = 0;
+    const void* pkBuffered = rSource.BufferedDataAtPosition(NumBuffered);
+    bool Success;
+
+    if (pkBuffered && NumBuffered >= CompressedSize)
+    {
+        Success = Decompress({static_cast<const uint8_t*>(pkBuffered), static_cast<size_t>(CompressedSize)}, Dst, NumThreads);
+        rSource.Skip(static_cast<int64_t>(CompressedSize));
+    }
+    else
+    {
+        std::vector<uint8_t> Compressed(static_cast<size_t>(CompressedSize));
+        const uint64_t Start = rSource.Tell();
+        rSource.ReadBytes(Compressed.data(), Compressed.size());
+
+        Success = (rSource.Tell() - Start == CompressedSize) && Decompress(Compressed, Dst, NumThreads);
+    }
+
+    return Success;
+}
+
+// ************ PRIVATE ************
+void CLZOInStream::Restart()
+{
+    mSourcePos = mSourceStart;
+    mPos = 0;
+    mNextSegmentPos = 0;
+    mSegmentPos = 0;
+    mSegmentFill = 0;
+    mError = false;
+}
+
+bool CLZOInStream::DecodeNextSegment(uint8_t *pDst, size_t DstSize, size_t& rOutSize)
+{
+    rOutSize = 0;
+
+    if (mSourceEnd - mSourcePos < 2 || mNextSegmentPos >= mDecompressedSize)
+    {
+        NLog::Error("{}: Compressed data ended before the end of the stream", mDataSource);
+        mError = true;
+        return false;
+    }
+
+    // Only reposition the source if something else moved it since our last read
+    if (mpSource->Tell() != mSourcePos)
+        mpSource->GoTo(mSourcePos);
+
+    uint8_t Header[2];
+    mpSource->ReadBytes(Header, sizeof(Header));
+
+    const int32_t Size = ReadSegmentHeader(Header);
+    const auto PayloadSize = static_cast<size_t>(Size < 0 ? -Size : Size);
+    const auto MaxOutput = static_cast<size_t>(Size < 0 ? PayloadSize : std::min<uint64_t>(skSegmentSize, mDecompressedSize - mNextSegmentPos));
+
+    if (Size == 0 || mSourceEnd - mSourcePos - 2 < PayloadSize || mDecompressedSize - mNextSegmentPos < MaxOutput)
+    {
+        NLog::Error("{}: Invalid compressed segment at offset 0x{:X}", mDataSource, mSourcePos);
+        mError = true;
+        return false;
+    }
+
+    // Decode directly into the caller's buffer if the whole segment fits in it
+    const bool IsDirect = (pDst != nullptr && DstSize >= MaxOutput);
+
+    if (!IsDirect)
+    {
+        if (mSegment.size() < MaxOutput)
+            mSegment.resize(MaxOutput);
+
+        pDst = mSegment.data();
+    }
+
+    const std::span<uint8_t> Out(pDst, MaxOutput);
+    bool Success = true;
+
+    if (Size < 0)
+    {
+        mpSource->ReadBytes(Out.data(), PayloadSize);
+        rOutSize = static_cast<size_t>(mpSource->Tell() - mSourcePos - 2);
+        Success = (rOutSize == PayloadSize);
+    }
+    else
+    {
+        // Use the source's own buffer for the payload if it has one
+        size_t NumBuffered = 0;
+        const void* pkBuffered = mpSource->BufferedDataAtPosition(NumBuffered);
+        const bool IsBorrowed = (pkBuffered && NumBuffered >= PayloadSize);
+        std::span<const uint8_t> Payload;
+
+        if (IsBorrowed)
+        {
+            Payload = {static_cast<const uint8_t*>(pkBuffered), PayloadSize};
+        }
+        else
+        {
+            if (mCompressedSegment.size() < PayloadSize)
+                mCompressedSegment.resize(PayloadSize);
+
+            mpSource->ReadBytes(mCompressedSegment.data(), PayloadSize);
+            Payload = {mCompressedSegment.data(), static_cast<size_t>(mpSource->Tell() - mSourcePos - 2)};
+        }
+
+        Success = (Payload.size() == PayloadSize && DecodeSegment(Payload, Out, rOutSize) && rOutSize > 0);
+
+        if (IsBorrowed)
+            mpSource->Skip(static_cast<int64_t>(PayloadSize));
+    }
+
+    if (!Success)
+    {
+        NLog::Error("{}: Failed to decompress segment at offset 0x{:X}", mDataSource, mSourcePos);
+        mError = true;
+        return false;
+    }
+
+    mSourcePos += 2 + PayloadSize;
+    mSegmentPos = mNextSegmentPos;
+    mSegmentFill = IsDirect ? 0 : static_cast<uint32_t>(rOutSize);
+    mNextSegmentPos += rOutSize;
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef AXIO_CLZOINSTREAM_H
+#define AXIO_CLZOINSTREAM_H
+
+#include "IInputStream.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Decompresses the segmented LZO1X format used for compressed resources in Echoes, Corruption
+// and the other games with 64-bit asset IDs. The data is a sequence of segments, each prefixed
+// with a big-endian int16 size: a negative size marks -Size bytes of uncompressed data, otherwise
+// Size bytes of LZO1X (or zlib, for some files) that decompress to a block of skSegmentSize bytes.
+//
+// As a stream, segments are decoded on demand; reads that cover a whole segment are decoded
+// straight into the caller's buffer. Decompress() does a whole block at once and can spread the
+// segments across multiple threads, since each segment is independent of the others.
+class CLZOInStream : public IInputStream
+{
+    IInputStream *mpSource = nullptr;
+    uint64_t mSourceStart = 0;
+    uint64_t mSourcePos = 0;        // Source offset of the next segment header
+    uint64_t mSourceEnd = 0;
+    uint64_t mDecompressedSize = 0;
+    uint64_t mPos = 0;
+    uint64_t mNextSegmentPos = 0;   // Decompressed offset where the next segment starts
+    bool mError = false;
+
+    // Most recently decoded segment, when it wasn't decoded into the caller's buffer directly
+    std::vector<uint8_t> mSegment;
+    uint64_t mSegmentPos = 0;
+    uint32_t mSegmentFill = 0;
+    std::vector<uint8_t> mCompressedSegment;
+
+public:
+    static constexpr uint32_t skSegmentSize = 0x4000;
+
+    CLZOInStream();
+    explicit CLZOInStream(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize);
+    ~CLZOInStream() override;
+
+    CLZOInStream(const CLZOInStream&) = delete;
+    CLZOInStream& operator=(const CLZOInStream&) = delete;
+
+    /** Starts decompressing from the source stream's current position */
+    void Open(IInputStream *pSource, uint64_t CompressedSize, uint64_t DecompressedSize);
+    void Close();
+
+    void ReadBytes(void* pDst, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
+    bool EoF() const override;
+    bool IsValid() const override;
+    uint64_t Size() const override;
+
+    /** Decodes a single raw LZO1X stream. rOutSize receives the number of bytes written. */
+    static bool DecompressLZO1X(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize);
+
+    /**
+     * Decodes a complete segmented block from Src into Dst, which must be exactly the
+     * decompressed size. NumThreads = 0 uses one thread per hardware thread.
+     */
+    static bool Decompress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, uint32_t NumThreads = 1);
+
+    /** Same as above, reading CompressedSize bytes from the stream's current position */
+    static bool Decompress(IInputStream& rSource, uint64_t CompressedSize, std::span<uint8_t> Dst, uint32_t NumThreads = 1);
+
+private:
+    void Restart();
+    bool DecodeNextSegment(uint8_t *pDst, size_t DstSize, size_t& rOutSize);
+};
+
+#endif // AXIO_CLZOINSTREAM_H
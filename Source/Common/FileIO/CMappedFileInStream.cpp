@@ -0,0 +1,305 @@
+#include "CMappedFileInStream.h"
+
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CMappedFileInStream::CMappedFileInStream() = default;
+
+CMappedFileInStream::CMappedFileInStream(const TString& rkFile, std::endian FileEndianness)
+{
+    Open(rkFile, FileEndianness);
+}
+
+CMappedFileInStream::~CMappedFileInStream()
+{
+    if (IsValid())
+        Close();
+}
+
+CMappedFileInStream::CMappedFileInStream(CMappedFileInStream&& Other) noexcept
+    : mpData{std::exchange(Other.mpData, nullptr)}
+    , mDataSize{std::exchange(Other.mDataSize, 0)}
+    , mPos{std::exchange(Other.mPos, 0)}
+    , mName{std::exchange(Other.mName, TString())}
+    , mIsOpen{std::exchange(Other.mIsOpen, false)}
+#ifdef _WIN32
+    , mhFile{std::exchange(Other.mhFile, nullptr)}
+    , mhMapping{std::exchange(Other.mhMapping, nullptr)}
+#endif
+{
+    mDataEndianness = Other.mDataEndianness;
+    mDataSource = std::exchange(Other.mDataSource, TString());
+}
+
+CMappedFileInStream& CMappedFileInStream::operator=(CMappedFileInStream&& Other) noexcept
+{
+    if (this == &Other)
+        return *this;
+
+    Close();
+    mpData = std::exchange(Other.mpData, nullptr);
+    mDataSize = std::exchange(Other.mDataSize, 0);
+    mPos = std::exchange(Other.mPos, 0);
+    mName = std::exchange(Other.mName, TString());
+    mIsOpen = std::exchange(Other.mIsOpen, false);
+#ifdef _WIN32
+    mhFile = std::exchange(Other.mhFile, nullptr);
+    mhMapping = std::exchange(Other.mhMapping, nullptr);
+#endif
+    mDataEndianness = Other.mDataEndianness;
+    mDataSource = std::exchange(Other.mDataSource, TString());
+    return *this;
+}
+
+void CMappedFileInStream::Open(const TString& rkFile, std::endian FileEndianness)
+{
+    if (IsValid())
+        Close();
+
+    mName = rkFile;
+    mDataEndianness = FileEndianness;
+    mPos = 0;
+    SetSourceString(rkFile.GetFileName());
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(ToWChar(rkFile), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER FileSize;
+
+    if (!GetFileSizeEx(hFile, &FileSize) || static_cast<uint64_t>(FileSize.QuadPart) > SIZE_MAX)
+    {
+        NLog::Error("{}: Unable to map file; size could not be determined or exceeds the address space", rkFile);
+        CloseHandle(hFile);
+        return;
+    }
+
+    mhFile = hFile;
+    mDataSize = static_cast<size_t>(FileSize.QuadPart);
+    mIsOpen = true;
+
+    // Zero-sized files can't be mapped, but they're still valid (empty) streams
+    if (mDataSize == 0)
+        return;
+
+    mhMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mhMapping)
+        mpData = static_cast<const char*>(MapViewOfFile(mhMapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (!mpData)
+    {
+        NLog::Error("{}: Failed to map file into memory", rkFile);
+        Close();
+    }
+#else
+    const int FileDesc = open(rkFile.CString(), O_RDONLY);
+
+    if (FileDesc == -1)
+        return;
+
+    struct stat FileStat;
+
+    if (fstat(FileDesc, &FileStat) != 0 || static_cast<uint64_t>(FileStat.st_size) > SIZE_MAX)
+    {
+        NLog::Error("{}: Unable to map file; size could not be determined or exceeds the address space", rkFile);
+        close(FileDesc);
+        return;
+    }
+
+    mDataSize = static_cast<size_t>(FileStat.st_size);
+    mIsOpen = true;
+
+    // Zero-sized files can't be mapped, but they're still valid (empty) streams
+    if (mDataSize > 0)
+    {
+        void *pMapping = mmap(nullptr, mDataSize, PROT_READ, MAP_PRIVATE, FileDesc, 0);
+
+        if (pMapping == MAP_FAILED)
+        {
+            NLog::Error("{}: Failed to map file into memory", rkFile);
+            mDataSize = 0;
+            mIsOpen = false;
+        }
+        else
+        {
+            mpData = static_cast<const char*>(pMapping);
+        }
+    }
+
+    // The mapping holds its own reference to the file, so the descriptor isn't needed anymore
+    close(FileDesc);
+#endif
+}
+
+void CMappedFileInStream::Close()
+{
+#ifdef _WIN32
+    if (mpData)
+        UnmapViewOfFile(mpData);
+    if (mhMapping)
+        CloseHandle(mhMapping);
+    if (mhFile)
+        CloseHandle(mhFile);
+
+    mhMapping = nullptr;
+    mhFile = nullptr;
+#else
+    if (mpData)
+        munmap(const_cast<char*>(mpData), mDataSize);
+#endif
+
+    mpData = nullptr;
+    mDataSize = 0;
+    mPos = 0;
+    mIsOpen = false;
+}
+
+bool CMappedFileInStream::SetAccessHint(EFileAccessHint Hint, size_t Offset /*= 0*/, size_t Size /*= 0*/)
+{
+    if (!mpData || Offset >= mDataSize)
+        return false;
+
+    const size_t MaxSize = mDataSize - Offset;
+    return AdviseMappedAccess(mpData + Offset, (Size == 0 || Size > MaxSize) ? MaxSize : Size, Hint);
+}
+
+void CMappedFileInStream::ReadBytes(void *pDst, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    // Clamp to the end of the file, matching fread's short-read behavior
+    if (Count > mDataSize - mPos)
+        Count = mDataSize - mPos;
+
+    if (Count == 0)
+        return;
+
+    memcpy(pDst, mpData + mPos, Count);
+    mPos += Count;
+}
+
+bool CMappedFileInStream::Seek(int64_t Offset, uint32_t Origin)
+{
+    if (!IsValid())
+        return false;
+
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mDataSize) + Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < 0)
+    {
+        mPos = 0;
+        return false;
+    }
+
+    if (static_cast<uint64_t>(NewPos) > mDataSize)
+    {
+        mPos = mDataSize;
+        return false;
+    }
+
+    mPos = static_cast<size_t>(NewPos);
+    return true;
+}
+
+uint64_t CMappedFileInStream::Tell() const
+{
+    return mPos;
+}
+
+bool CMappedFileInStream::EoF() const
+{
+    return (mPos >= mDataSize);
+}
+
+bool CMappedFileInStream::IsValid() const
+{
+    return mIsOpen;
+}
+
+uint64_t CMappedFileInStream::Size() const
+{
+    return mDataSize;
+}
+
+TString CMappedFileInStream::FileName() const
+{
+    return mName;
+}
+
+const void* CMappedFileInStream::Data() const
+{
+    return mpData;
+}
+
+const void* CMappedFileInStream::DataAtPosition() const
+{
+    return mpData + mPos;
+}
+
+const void* CMappedFileInStream::BufferedDataAtPosition(size_t& rOutSize) const
+{
+    rOutSize = (mPos < mDataSize) ? mDataSize - mPos : 0;
+    return rOutSize > 0 ? DataAtPosition() : nullptr;
+}
+
+bool CMappedFileInStream::SupportsReadAt() const
+{
+    return true;
+}
+
+size_t CMappedFileInStream::ReadAt(uint64_t Offset, void *pDst, size_t Count) const
+{
+    if (Offset >= mDataSize)
+        return 0;
+
+    Count = static_cast<size_t>(std::min<uint64_t>(Count, mDataSize - Offset));
+    memcpy(pDst, mpData + Offset, Count);
+    return Count;
+}
+
+std::span<const uint8_t> CMappedFileInStream::Span() const
+{
+    return {reinterpret_cast<const uint8_t*>(mpData), mDataSize};
+}
+
+std::span<const uint8_t> CMappedFileInStream::Span(size_t Offset, size_t Size) const
+{
+    ASSERT(Offset <= mDataSize && Size <= mDataSize - Offset);
+    return {reinterpret_cast<const uint8_t*>(mpData) + Offset, Size};
+}
@@ -0,0 +1,61 @@
+#ifndef AXIO_CMAPPEDFILEINSTREAM_H
+#define AXIO_CMAPPEDFILEINSTREAM_H
+
+#include "EFileAccessHint.h"
+#include "IInputStream.h"
+
+#include <cstdint>
+#include <span>
+
+// Input stream that maps an entire file into memory. Reads are served straight out of the
+// mapping, so there is no stdio locking or intermediate copy, and callers can take pointers
+// into the file contents directly via Data()/Span() for as long as the stream stays open.
+class CMappedFileInStream : public IInputStream
+{
+private:
+    const char *mpData = nullptr;
+    size_t mDataSize = 0;
+    size_t mPos = 0;
+    TString mName;
+    bool mIsOpen = false;
+
+#ifdef _WIN32
+    void *mhFile = nullptr;
+    void *mhMapping = nullptr;
+#endif
+
+public:
+    CMappedFileInStream();
+    explicit CMappedFileInStream(const TString& rkFile, std::endian FileEndianness);
+    ~CMappedFileInStream() override;
+
+    CMappedFileInStream(const CMappedFileInStream&) = delete;
+    CMappedFileInStream& operator=(const CMappedFileInStream&) = delete;
+
+    CMappedFileInStream(CMappedFileInStream&& Other) noexcept;
+    CMappedFileInStream& operator=(CMappedFileInStream&& Other) noexcept;
+
+    void Open(const TString& rkFile, std::endian FileEndianness);
+    void Close();
+
+    void ReadBytes(void* pDst, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
+    bool EoF() const override;
+    bool IsValid() const override;
+    uint64_t Size() const override;
+    TString FileName() const;
+
+    /** Passes an access pattern hint for a range of the mapping on to the OS. Size 0 means to the end. */
+    bool SetAccessHint(EFileAccessHint Hint, size_t Offset = 0, size_t Size = 0);
+
+    const void* Data() const;
+    const void* DataAtPosition() const;
+    const void* BufferedDataAtPosition(size_t& rOutSize) const override;
+    bool SupportsReadAt() const override;
+    size_t ReadAt(uint64_t Offset, void *pDst, size_t Count) const override;
+    std::span<const uint8_t> Span() const;
+    std::span<const uint8_t> Span(size_t Offset, size_t Size) const;
+};
+
+#endif // AXIO_CMAPPEDFILEINSTREAM_H
@@ -1,15 +1,18 @@
 #include "CMemoryInStream.h"
 
+#include <algorithm>
+#include <cstring>
+
 CMemoryInStream::CMemoryInStream() = default;
 
-CMemoryInStream::CMemoryInStream(const void *pkData, uint32_t Size, std::endian DataEndianness)
+CMemoryInStream::CMemoryInStream(const void *pkData, size_t Size, std::endian DataEndianness)
 {
     SetData(pkData, Size, DataEndianness);
 }
 
 CMemoryInStream::~CMemoryInStream() = default;
 
-void CMemoryInStream::SetData(const void *pkData, uint32_t Size, std::endian DataEndianness)
+void CMemoryInStream::SetData(const void *pkData, size_t Size, std::endian DataEndianness)
 {
     mpDataStart = (const char*) pkData;
     mDataSize = Size;
@@ -17,7 +20,7 @@ void CMemoryInStream::SetData(const void *pkData, uint32_t Size, std::endian Dat
     mDataEndianness = DataEndianness;
 }
 
-void CMemoryInStream::ReadBytes(void *pDst, uint32_t Count)
+void CMemoryInStream::ReadBytes(void *pDst, size_t Count)
 {
     if (!IsValid())
         return;
@@ -26,45 +29,48 @@ void CMemoryInStream::ReadBytes(void *pDst, uint32_t Count)
     mPos += Count;
 }
 
-bool CMemoryInStream::Seek(int32_t Offset, uint32_t Origin)
+bool CMemoryInStream::Seek(int64_t Offset, uint32_t Origin)
 {
     if (!IsValid())
         return false;
 
+    int64_t NewPos;
+
     switch (Origin)
     {
         case SEEK_SET:
-            mPos = Offset;
+            NewPos = Offset;
             break;
 
         case SEEK_CUR:
-            mPos += Offset;
+            NewPos = static_cast<int64_t>(mPos) + Offset;
             break;
 
         case SEEK_END:
-            mPos = mDataSize - Offset;
+            NewPos = static_cast<int64_t>(mDataSize) - Offset;
             break;
 
         default:
             return false;
     }
 
-    if (mPos < 0)
+    if (NewPos < 0)
     {
         mPos = 0;
         return false;
     }
 
-    if (mPos > mDataSize)
+    if (static_cast<uint64_t>(NewPos) > mDataSize)
     {
         mPos = mDataSize;
         return false;
     }
 
+    mPos = static_cast<size_t>(NewPos);
     return true;
 }
 
-uint32_t CMemoryInStream::Tell() const
+uint64_t CMemoryInStream::Tell() const
 {
     return mPos;
 }
@@ -79,12 +85,12 @@ bool CMemoryInStream::IsValid() const
     return (mpDataStart != nullptr);
 }
 
-uint32_t CMemoryInStream::Size() const
+uint64_t CMemoryInStream::Size() const
 {
     return mDataSize;
 }
 
-void CMemoryInStream::SetSize(uint32_t Size)
+void CMemoryInStream::SetSize(size_t Size)
 {
     mDataSize = Size;
     if (mPos > mDataSize)
@@ -100,3 +106,24 @@ const void* CMemoryInStream::DataAtPosition() const
 {
     return mpDataStart + mPos;
 }
+
+const void* CMemoryInStream::BufferedDataAtPosition(size_t& rOutSize) const
+{
+    rOutSize = (IsValid() && mPos < mDataSize) ? mDataSize - mPos : 0;
+    return rOutSize > 0 ? DataAtPosition() : nullptr;
+}
+
+bool CMemoryInStream::SupportsReadAt() const
+{
+    return true;
+}
+
+size_t CMemoryInStream::ReadAt(uint64_t Offset, void *pDst, size_t Count) const
+{
+    if (!IsValid() || Offset >= mDataSize)
+        return 0;
+
+    Count = static_cast<size_t>(std::min<uint64_t>(Count, mDataSize - Offset));
+    memcpy(pDst, mpDataStart + Offset, Count);
+    return Count;
+}
@@ -6,25 +6,28 @@
 class CMemoryInStream : public IInputStream
 {
     const char *mpDataStart = nullptr;
-    uint32_t mDataSize = 0;
-    uint32_t mPos = 0;
+    size_t mDataSize = 0;
+    size_t mPos = 0;
 
 public:
     CMemoryInStream();
-    explicit CMemoryInStream(const void *pkData, uint32_t Size, std::endian dataEndianness);
+    explicit CMemoryInStream(const void *pkData, size_t Size, std::endian dataEndianness);
     ~CMemoryInStream() override;
 
-    void SetData(const void *pkData, uint32_t Size, std::endian dataEndianness);
+    void SetData(const void *pkData, size_t Size, std::endian dataEndianness);
 
-    void ReadBytes(void* pDst, uint32_t Count) override;
-    bool Seek(int32_t Offset, uint32_t Origin) override;
-    uint32_t Tell() const override;
+    void ReadBytes(void* pDst, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
     bool EoF() const override;
     bool IsValid() const override;
-    uint32_t Size() const override;
-    void SetSize(uint32_t Size);
+    uint64_t Size() const override;
+    void SetSize(size_t Size);
     const void* Data() const;
     const void* DataAtPosition() const;
+    const void* BufferedDataAtPosition(size_t& rOutSize) const override;
+    bool SupportsReadAt() const override;
+    size_t ReadAt(uint64_t Offset, void *pDst, size_t Count) const override;
 };
 
 #endif // AXIO_CMEMORYINSTREAM_H
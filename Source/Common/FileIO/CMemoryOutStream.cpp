@@ -2,14 +2,14 @@
 
 CMemoryOutStream::CMemoryOutStream() = default;
 
-CMemoryOutStream::CMemoryOutStream(void *pData, uint32_t Size, std::endian DataEndianness)
+CMemoryOutStream::CMemoryOutStream(void *pData, size_t Size, std::endian DataEndianness)
 {
     SetData(pData, Size, DataEndianness);
 }
 
 CMemoryOutStream::~CMemoryOutStream() = default;
 
-void CMemoryOutStream::SetData(void *pData, uint32_t Size, std::endian DataEndianness)
+void CMemoryOutStream::SetData(void *pData, size_t Size, std::endian DataEndianness)
 {
     mpDataStart = (char*) pData;
     mDataSize = Size;
@@ -18,7 +18,7 @@ void CMemoryOutStream::SetData(void *pData, uint32_t Size, std::endian DataEndia
     mDataEndianness = DataEndianness;
 }
 
-void CMemoryOutStream::WriteBytes(const void *pkSrc, uint32_t Count)
+void CMemoryOutStream::WriteBytes(const void *pkSrc, size_t Count)
 {
     if (!IsValid())
         return;
@@ -29,45 +29,48 @@ void CMemoryOutStream::WriteBytes(const void *pkSrc, uint32_t Count)
         mUsed = mPos;
 }
 
-bool CMemoryOutStream::Seek(int32_t Offset, uint32_t Origin)
+bool CMemoryOutStream::Seek(int64_t Offset, uint32_t Origin)
 {
     if (!IsValid())
         return false;
 
+    int64_t NewPos;
+
     switch (Origin)
     {
         case SEEK_SET:
-            mPos = Offset;
+            NewPos = Offset;
             break;
 
         case SEEK_CUR:
-            mPos += Offset;
+            NewPos = static_cast<int64_t>(mPos) + Offset;
             break;
 
         case SEEK_END:
-            mPos = mDataSize - Offset;
+            NewPos = static_cast<int64_t>(mDataSize) - Offset;
             break;
 
         default:
             return false;
     }
 
-    if (mPos < 0)
+    if (NewPos < 0)
     {
         mPos = 0;
         return false;
     }
 
-    if (mPos > mDataSize)
+    if (static_cast<uint64_t>(NewPos) > mDataSize)
     {
         mPos = mDataSize;
         return false;
     }
 
+    mPos = static_cast<size_t>(NewPos);
     return true;
 }
 
-uint32_t CMemoryOutStream::Tell() const
+uint64_t CMemoryOutStream::Tell() const
 {
     return mPos;
 }
@@ -82,17 +85,29 @@ bool CMemoryOutStream::IsValid() const
     return (mpDataStart != nullptr);
 }
 
-uint32_t CMemoryOutStream::Size() const
+uint64_t CMemoryOutStream::Size() const
 {
     return mDataSize;
 }
 
-uint32_t CMemoryOutStream::SpaceUsed() const
+void CMemoryOutStream::PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    ASSERT(Offset + Count <= mDataSize);
+    memcpy(mpDataStart + Offset, pkSrc, Count);
+
+    if (Offset + Count > mUsed)
+        mUsed = static_cast<size_t>(Offset + Count);
+}
+
+size_t CMemoryOutStream::SpaceUsed() const
 {
     return mUsed;
 }
 
-void CMemoryOutStream::SetSize(uint32_t Size)
+void CMemoryOutStream::SetSize(size_t Size)
 {
     mDataSize = Size;
     if (mPos > mDataSize)
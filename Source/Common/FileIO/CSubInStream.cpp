@@ -0,0 +1,204 @@
+#include "CSubInStream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+CSubInStream::CSubInStream() = default;
+
+CSubInStream::CSubInStream(IInputStream *pParent, uint64_t Offset, uint64_t Size, bool Positional /*= false*/)
+{
+    SetWindow(pParent, Offset, Size, Positional);
+}
+
+CSubInStream::~CSubInStream() = default;
+
+void CSubInStream::SetWindow(IInputStream *pParent, uint64_t Offset, uint64_t Size, bool Positional /*= false*/)
+{
+    mpParent = pParent;
+    mOffset = Offset;
+    mSize = Size;
+    mPos = 0;
+    mPositional = Positional && mpParent && mpParent->SupportsReadAt();
+    mBufferPos = 0;
+    mBufferFill = 0;
+
+    if (mPositional)
+        mBuffer.resize(skPositionalBufferSize);
+    else
+        mBuffer = std::vector<char>();
+
+    if (mpParent)
+    {
+        mDataEndianness = mpParent->GetEndianness();
+        SetSourceString(mpParent->GetSourceString());
+    }
+}
+
+void CSubInStream::ReadBytes(void *pDst, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    if (Count > mSize - mPos)
+        Count = static_cast<size_t>(mSize - mPos);
+
+    if (mPositional)
+    {
+        auto *pOut = static_cast<char*>(pDst);
+
+        while (Count > 0)
+        {
+            if (mPos >= mBufferPos && mPos < mBufferPos + mBufferFill)
+            {
+                const auto BufferPos = static_cast<uint32_t>(mPos - mBufferPos);
+                const auto NumBytes = std::min<size_t>(Count, mBufferFill - BufferPos);
+                memcpy(pOut, mBuffer.data() + BufferPos, NumBytes);
+                pOut += NumBytes;
+                mPos += NumBytes;
+                Count -= NumBytes;
+            }
+            // Reads that wouldn't fit in the buffer anyway go straight to the destination
+            else if (Count >= mBuffer.size())
+            {
+                mPos += mpParent->ReadAt(mOffset + mPos, pOut, Count);
+                return;
+            }
+            else
+            {
+                const auto NumToFill = static_cast<size_t>(std::min<uint64_t>(mBuffer.size(), mSize - mPos));
+                mBufferPos = mPos;
+                mBufferFill = static_cast<uint32_t>(mpParent->ReadAt(mOffset + mPos, mBuffer.data(), NumToFill));
+
+                if (mBufferFill == 0)
+                    return;
+            }
+        }
+
+        return;
+    }
+
+    // Only reposition the parent if something else moved it since our last read
+    const uint64_t ParentPos = mOffset + mPos;
+
+    if (mpParent->Tell() != ParentPos)
+        mpParent->GoTo(ParentPos);
+
+    mpParent->ReadBytes(pDst, Count);
+    mPos += Count;
+}
+
+bool CSubInStream::Seek(int64_t Offset, uint32_t Origin)
+{
+    if (!IsValid())
+        return false;
+
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mSize) + Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < 0)
+    {
+        mPos = 0;
+        return false;
+    }
+
+    if (static_cast<uint64_t>(NewPos) > mSize)
+    {
+        mPos = mSize;
+        return false;
+    }
+
+    mPos = static_cast<uint64_t>(NewPos);
+    return true;
+}
+
+uint64_t CSubInStream::Tell() const
+{
+    return mPos;
+}
+
+bool CSubInStream::EoF() const
+{
+    return (mPos >= mSize);
+}
+
+bool CSubInStream::IsValid() const
+{
+    return (mpParent != nullptr && mpParent->IsValid());
+}
+
+uint64_t CSubInStream::Size() const
+{
+    return mSize;
+}
+
+const void* CSubInStream::BufferedDataAtPosition(size_t& rOutSize) const
+{
+    rOutSize = 0;
+
+    if (mPositional)
+    {
+        if (mPos < mBufferPos || mPos >= mBufferPos + mBufferFill)
+            return nullptr;
+
+        const auto BufferPos = static_cast<uint32_t>(mPos - mBufferPos);
+        rOutSize = mBufferFill - BufferPos;
+        return mBuffer.data() + BufferPos;
+    }
+
+    // The parent's buffer is only usable if it's currently positioned where we are
+    if (!IsValid() || mpParent->Tell() != mOffset + mPos)
+        return nullptr;
+
+    size_t NumBuffered = 0;
+    const void* pkData = mpParent->BufferedDataAtPosition(NumBuffered);
+
+    rOutSize = static_cast<size_t>(std::min<uint64_t>(NumBuffered, mSize - mPos));
+    return rOutSize > 0 ? pkData : nullptr;
+}
+
+bool CSubInStream::SupportsReadAt() const
+{
+    return mpParent != nullptr && mpParent->SupportsReadAt();
+}
+
+size_t CSubInStream::ReadAt(uint64_t Offset, void *pDst, size_t Count) const
+{
+    if (!IsValid() || Offset >= mSize)
+        return 0;
+
+    Count = static_cast<size_t>(std::min<uint64_t>(Count, mSize - Offset));
+    return mpParent->ReadAt(mOffset + Offset, pDst, Count);
+}
+
+bool CSubInStream::IsPositional() const
+{
+    return mPositional;
+}
+
+IInputStream* CSubInStream::Parent() const
+{
+    return mpParent;
+}
+
+uint64_t CSubInStream::Offset() const
+{
+    return mOffset;
+}
@@ -0,0 +1,51 @@
+#ifndef AXIO_CSUBINSTREAM_H
+#define AXIO_CSUBINSTREAM_H
+
+#include "IInputStream.h"
+
+#include <vector>
+
+// Read-only view of an [Offset, Offset + Size) window of another input stream. Positions, sizes
+// and EoF are all relative to the window, so embedded files can be handed to parsers directly
+// without copying them out of their container first. The parent stream must outlive the view.
+//
+// Positional views read through the parent's ReadAt() into a small buffer of their own instead of
+// moving the parent's cursor, so any number of them can parse the same parent on different threads.
+// Parents that don't support ReadAt() fall back to a normal view.
+class CSubInStream : public IInputStream
+{
+    IInputStream *mpParent = nullptr;
+    uint64_t mOffset = 0;
+    uint64_t mSize = 0;
+    uint64_t mPos = 0;
+
+    // Positional mode only
+    std::vector<char> mBuffer;
+    uint64_t mBufferPos = 0;        // Window offset of mBuffer[0]
+    uint32_t mBufferFill = 0;
+    bool mPositional = false;
+
+public:
+    static constexpr uint32_t skPositionalBufferSize = 0x1000;
+
+    CSubInStream();
+    explicit CSubInStream(IInputStream *pParent, uint64_t Offset, uint64_t Size, bool Positional = false);
+    ~CSubInStream() override;
+
+    void SetWindow(IInputStream *pParent, uint64_t Offset, uint64_t Size, bool Positional = false);
+    bool IsPositional() const;
+
+    void ReadBytes(void* pDst, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
+    bool EoF() const override;
+    bool IsValid() const override;
+    uint64_t Size() const override;
+    const void* BufferedDataAtPosition(size_t& rOutSize) const override;
+    bool SupportsReadAt() const override;
+    size_t ReadAt(uint64_t Offset, void *pDst, size_t Count) const override;
+    IInputStream* Parent() const;
+    uint64_t Offset() const;
+};
+
+#endif // AXIO_CSUBINSTREAM_H
@@ -1,5 +1,7 @@
 #include "CVectorOutStream.h"
-#include "Common/Math/MathUtil.h"
+
+#include <algorithm>
+#include <utility>
 
 CVectorOutStream::CVectorOutStream()
     : mpVector(new std::vector<char>())
@@ -13,7 +15,7 @@ CVectorOutStream::CVectorOutStream(std::endian DataEndianness)
     mDataEndianness = DataEndianness;
 }
 
-CVectorOutStream::CVectorOutStream(uint32_t InitialSize, std::endian DataEndianness)
+CVectorOutStream::CVectorOutStream(size_t InitialSize, std::endian DataEndianness)
     : mpVector(new std::vector<char>(InitialSize))
 {
     mDataEndianness = DataEndianness;
@@ -32,61 +34,77 @@ CVectorOutStream::~CVectorOutStream()
         delete mpVector;
 }
 
-void CVectorOutStream::WriteBytes(const void *pkSrc, uint32_t Count)
+void CVectorOutStream::WriteBytes(const void *pkSrc, size_t Count)
 {
     if (!IsValid())
         return;
 
-    uint32_t NewSize = mPos + Count;
+    const size_t NewSize = mPos + Count;
+    const size_t CurSize = mpVector->size();
 
-    if (NewSize > mpVector->size())
+    if (NewSize > CurSize)
     {
-        if (NewSize > mpVector->capacity())
-            mpVector->reserve(Math::Align(mPos + Count, skAllocSize));
-
-        mpVector->resize(NewSize);
+        GrowCapacity(NewSize);
+
+        // Overwrite whatever overlaps the existing data, then append the rest directly
+        // rather than zero-filling it with resize() first
+        const auto* pkBytes = static_cast<const char*>(pkSrc);
+        const size_t NumOverlap = CurSize - mPos;
+        memcpy(mpVector->data() + mPos, pkBytes, NumOverlap);
+        mpVector->insert(mpVector->end(), pkBytes + NumOverlap, pkBytes + Count);
+    }
+    else
+    {
+        memcpy(mpVector->data() + mPos, pkSrc, Count);
     }
 
-    memcpy(mpVector->data() + mPos, pkSrc, Count);
     mPos += Count;
 }
 
-bool CVectorOutStream::Seek(int32_t Offset, uint32_t Origin)
+bool CVectorOutStream::Seek(int64_t Offset, uint32_t Origin)
 {
     if (!IsValid())
         return false;
 
+    int64_t NewPos;
+
     switch (Origin)
     {
         case SEEK_SET:
-            mPos = Offset;
+            NewPos = Offset;
             break;
 
         case SEEK_CUR:
-            mPos += Offset;
+            NewPos = static_cast<int64_t>(mPos) + Offset;
             break;
 
         case SEEK_END:
-            mPos = mpVector->size() - Offset;
+            NewPos = static_cast<int64_t>(mpVector->size()) - Offset;
             break;
 
         default:
             return false;
     }
 
-    if (mPos < 0)
+    if (NewPos < 0)
     {
         mPos = 0;
         return false;
     }
 
+    mPos = static_cast<size_t>(NewPos);
+
+    // Seeking past the end behaves like a file; the gap reads back as zeroes
     if (mPos > mpVector->size())
+    {
+        GrowCapacity(mPos);
         mpVector->resize(mPos);
+    }
 
     return true;
 }
 
-uint32_t CVectorOutStream::Tell() const
+uint64_t CVectorOutStream::Tell() const
 {
     return mPos;
 }
@@ -101,11 +119,35 @@ bool CVectorOutStream::IsValid() const
     return true;
 }
 
-uint32_t CVectorOutStream::Size() const
+uint64_t CVectorOutStream::Size() const
 {
     return mPos;
 }
 
+void CVectorOutStream::PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count)
+{
+    // Patches that extend past the current data need the usual growth handling
+    if (Offset + Count > mpVector->size())
+    {
+        IOutputStream::PatchBytes(Offset, pkSrc, Count);
+        return;
+    }
+
+    memcpy(mpVector->data() + Offset, pkSrc, Count);
+}
+
+void CVectorOutStream::WriteGather(std::span<const std::span<const uint8_t>> Buffers)
+{
+    // Size the vector for the whole list up front so each buffer is copied exactly once
+    size_t TotalSize = 0;
+
+    for (const std::span<const uint8_t>& rkBuffer : Buffers)
+        TotalSize += rkBuffer.size();
+
+    GrowCapacity(mPos + TotalSize);
+    IOutputStream::WriteGather(Buffers);
+}
+
 void CVectorOutStream::SetVector(std::vector<char> *pVector)
 {
     if (mOwnsVector)
@@ -118,6 +160,24 @@ void CVectorOutStream::SetVector(std::vector<char> *pVector)
     mPos = 0;
 }
 
+void CVectorOutStream::Reserve(size_t Capacity)
+{
+    mpVector->reserve(Capacity);
+}
+
+void CVectorOutStream::ShrinkToFit()
+{
+    mpVector->shrink_to_fit();
+}
+
+std::vector<char> CVectorOutStream::TakeVector()
+{
+    std::vector<char> Out = std::move(*mpVector);
+    mpVector->clear();
+    mPos = 0;
+    return Out;
+}
+
 void* CVectorOutStream::Data()
 {
     return mpVector->data();
@@ -143,3 +203,11 @@ void CVectorOutStream::Clear()
     mPos = 0;
     mpVector->clear();
 }
+
+// ************ PRIVATE ************
+void CVectorOutStream::GrowCapacity(size_t MinCapacity)
+{
+    // Grow geometrically so that large outputs only reallocate a logarithmic number of times
+    if (MinCapacity > mpVector->capacity())
+        mpVector->reserve(std::max(MinCapacity, mpVector->capacity() * 2));
+}
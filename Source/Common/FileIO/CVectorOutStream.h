@@ -6,31 +6,37 @@
 
 class CVectorOutStream : public IOutputStream
 {
-    static constexpr uint32_t skAllocSize = 1; // must be 1 or a power of 2
-
     std::vector<char> *mpVector;
     bool mOwnsVector = true;
-    uint32_t mPos = 0;
+    size_t mPos = 0;
 
 public:
     CVectorOutStream();
     explicit CVectorOutStream(std::endian DataEndianness);
-    explicit CVectorOutStream(uint32_t InitialSize, std::endian DataEndianness);
+    explicit CVectorOutStream(size_t InitialSize, std::endian DataEndianness);
     explicit CVectorOutStream(std::vector<char> *pVector, std::endian DataEndianness);
     ~CVectorOutStream() override;
 
-    void WriteBytes(const void* pkSrc, uint32_t Count) override;
-    bool Seek(int32_t Offset, uint32_t Origin) override;
-    uint32_t Tell() const override;
+    void WriteBytes(const void* pkSrc, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
     bool EoF() const override;
     bool IsValid() const override;
-    uint32_t Size() const override;
+    uint64_t Size() const override;
+    void PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count) override;
+    void WriteGather(std::span<const std::span<const uint8_t>> Buffers) override;
     void SetVector(std::vector<char> *pVector);
+    void Reserve(size_t Capacity);
+    void ShrinkToFit();
+    std::vector<char> TakeVector();
     void* Data();
     const void* Data() const;
     void* DataAtPosition();
     const void* DataAtPosition() const;
     void Clear();
+
+private:
+    void GrowCapacity(size_t MinCapacity);
 };
 
 #endif // AXIO_CVECTOROUTSTREAM_H
@@ -0,0 +1,423 @@
+#include "CYaz0InStream.h"
+
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// The longest operation is a code byte followed by a three-byte back-reference
+constexpr size_t kMaxOpSize = 4;
+
+// Copies a back-reference of Len bytes starting Dist bytes behind pOut. Room is how many bytes
+// may be written at pOut; when there's enough slack past the end of the match, the copy runs in
+// 16- or 8-byte chunks and lets the last chunk spill over, since later output overwrites it anyway.
+void CopyMatch(uint8_t *pOut, size_t Dist, size_t Len, size_t Room)
+{
+    const uint8_t *pkSrc = pOut - Dist;
+
+    if (Dist >= 16 && Room >= Len + 15)
+    {
+        for (size_t Offset = 0; Offset < Len; Offset += 16)
+            std::memcpy(pOut + Offset, pkSrc + Offset, 16);
+    }
+    else if (Dist >= 8 && Room >= Len + 7)
+    {
+        for (size_t Offset = 0; Offset < Len; Offset += 8)
+            std::memcpy(pOut + Offset, pkSrc + Offset, 8);
+    }
+    else
+    {
+        // Short distances repeat with period Dist, so each pass can copy everything the match
+        // has written so far, doubling the chunk size instead of going byte by byte
+        size_t Done = 0;
+
+        for (size_t Period = Dist; Done < Len; Period *= 2)
+        {
+            const size_t Chunk = std::min(Period, Len - Done);
+            std::memcpy(pOut + Done, pOut + Done - Period, Chunk);
+            Done += Chunk;
+        }
+    }
+}
+
+// Decodes from [rpkIn, pkInEnd) into pOut, from rOutPos up to OutEnd. Everything before rOutPos
+// is history available to back-references. Unless IsLastInput is set, decoding stops early when
+// the input might end partway through an operation, so the caller can refill it and resume.
+// Returns false if the data is corrupt.
+bool DecodeYaz0(CYaz0InStream::SDecodeState& rState, const uint8_t *&rpkIn, const uint8_t *pkInEnd, bool IsLastInput,
+                uint8_t *pOut, size_t& rOutPos, size_t OutEnd)
+{
+    const uint8_t *pkIn = rpkIn;
+    size_t OutPos = rOutPos;
+    bool Success = true;
+
+    // Finish a back-reference that didn't fit in the output last time
+    if (rState.MatchLen > 0)
+    {
+        const size_t Len = std::min<size_t>(rState.MatchLen, OutEnd - OutPos);
+        CopyMatch(pOut + OutPos, rState.MatchDist, Len, OutEnd - OutPos);
+        OutPos += Len;
+        rState.MatchLen -= static_cast<uint32_t>(Len);
+    }
+
+    while (OutPos < OutEnd)
+    {
+        const size_t InRemaining = pkInEnd - pkIn;
+
+        if (InRemaining < kMaxOpSize && !IsLastInput)
+            break;
+
+        if (rState.NumCodeBits == 0)
+        {
+            if (InRemaining == 0)
+            {
+                Success = false;
+                break;
+            }
+
+            rState.CodeByte = *pkIn++;
+            rState.NumCodeBits = 8;
+
+            // A group of eight literals is common enough in poorly compressible data to copy at once
+            if (rState.CodeByte == 0xFF && pkInEnd - pkIn >= 8 && OutEnd - OutPos >= 8)
+            {
+                std::memcpy(pOut + OutPos, pkIn, 8);
+                pkIn += 8;
+                OutPos += 8;
+                rState.NumCodeBits = 0;
+                continue;
+            }
+        }
+
+        if (rState.CodeByte & 0x80)
+        {
+            if (pkIn == pkInEnd)
+            {
+                Success = false;
+                break;
+            }
+
+            pOut[OutPos++] = *pkIn++;
+        }
+        else
+        {
+            if (pkInEnd - pkIn < 2)
+            {
+                Success = false;
+                break;
+            }
+
+            const size_t Dist = (((pkIn[0] & 0xF) << 8) | pkIn[1]) + 1;
+            size_t Len = pkIn[0] >> 4;
+            pkIn += 2;
+
+            if (Len == 0)
+            {
+                if (pkIn == pkInEnd)
+                {
+                    Success = false;
+                    break;
+                }
+
+                Len = *pkIn++ + 0x12;
+            }
+            else
+            {
+                Len += 2;
+            }
+
+            if (Dist > OutPos)
+            {
+                Success = false;
+                break;
+            }
+
+            const size_t NumToCopy = std::min(Len, OutEnd - OutPos);
+            CopyMatch(pOut + OutPos, Dist, NumToCopy, OutEnd - OutPos);
+            OutPos += NumToCopy;
+            rState.MatchDist = static_cast<uint32_t>(Dist);
+            rState.MatchLen = static_cast<uint32_t>(Len - NumToCopy);
+        }
+
+        rState.CodeByte <<= 1;
+        rState.NumCodeBits--;
+    }
+
+    rpkIn = pkIn;
+    rOutPos = OutPos;
+    return Success;
+}
+
+} // anonymous namespace
+
+CYaz0InStream::CYaz0InStream() = default;
+
+CYaz0InStream::CYaz0InStream(IInputStream *pSource, uint64_t CompressedSize)
+{
+    Open(pSource, CompressedSize);
+}
+
+CYaz0InStream::~CYaz0InStream() = default;
+
+void CYaz0InStream::Open(IInputStream *pSource, uint64_t CompressedSize)
+{
+    Close();
+
+    if (!pSource || !pSource->IsValid())
+        return;
+
+    uint8_t Header[skHeaderSize];
+    uint32_t DecompressedSize;
+    const uint64_t Start = pSource->Tell();
+    pSource->ReadBytes(Header, sizeof(Header));
+
+    if (CompressedSize < skHeaderSize || pSource->Tell() - Start != skHeaderSize || !ReadHeader(Header, DecompressedSize))
+    {
+        NLog::Error("{}: Invalid Yaz0 header", pSource->GetSourceString());
+        return;
+    }
+
+    mDataEndianness = pSource->GetEndianness();
+    SetSourceString(pSource->GetSourceString());
+
+    mpSource = pSource;
+    mSourceStart = Start + skHeaderSize;
+    mSourceEnd = Start + CompressedSize;
+    mDecompressedSize = DecompressedSize;
+    Restart();
+}
+
+void CYaz0InStream::Close()
+{
+    mpSource = nullptr;
+    mSourceStart = 0;
+    mSourceEnd = 0;
+    mDecompressedSize = 0;
+    Restart();
+}
+
+void CYaz0InStream::ReadBytes(void *pDst, size_t Count)
+{
+    if (!IsValid())
+        return;
+
+    auto *pOut = static_cast<uint8_t*>(pDst);
+    Count = static_cast<size_t>(std::min<uint64_t>(Count, mDecompressedSize - mPos));
+
+    while (Count > 0)
+    {
+        const uint64_t WindowEnd = mWindowStart + mWindowFill;
+
+        if (mPos < WindowEnd)
+        {
+            const size_t NumToCopy = static_cast<size_t>(std::min<uint64_t>(Count, WindowEnd - mPos));
+            std::memcpy(pOut, &mWindow[mPos - mWindowStart], NumToCopy);
+            pOut += NumToCopy;
+            Count -= NumToCopy;
+            mPos += NumToCopy;
+        }
+        else if (!FillWindow())
+        {
+            break;
+        }
+    }
+}
+
+bool CYaz0InStream::Seek(int64_t Offset, uint32_t Origin)
+{
+    if (!IsValid())
+        return false;
+
+    int64_t NewPos;
+
+    switch (Origin)
+    {
+        case SEEK_SET:
+            NewPos = Offset;
+            break;
+
+        case SEEK_CUR:
+            NewPos = static_cast<int64_t>(mPos) + Offset;
+            break;
+
+        case SEEK_END:
+            NewPos = static_cast<int64_t>(mDecompressedSize) + Offset;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (NewPos < 0 || static_cast<uint64_t>(NewPos) > mDecompressedSize)
+        return false;
+
+    const auto Target = static_cast<uint64_t>(NewPos);
+
+    if (Target < mWindowStart)
+        Restart();
+
+    while (Target > mWindowStart + mWindowFill)
+    {
+        if (!FillWindow())
+            return false;
+    }
+
+    mPos = Target;
+    return true;
+}
+
+uint64_t CYaz0InStream::Tell() const
+{
+    return mPos;
+}
+
+bool CYaz0InStream::EoF() const
+{
+    return mError || mPos >= mDecompressedSize;
+}
+
+bool CYaz0InStream::IsValid() const
+{
+    return mpSource != nullptr && mpSource->IsValid();
+}
+
+uint64_t CYaz0InStream::Size() const
+{
+    return mDecompressedSize;
+}
+
+bool CYaz0InStream::ReadHeader(std::span<const uint8_t> Src, uint32_t& rDecompressedSize)
+{
+    if (Src.size() < skHeaderSize || std::memcmp(Src.data(), "Yaz0", 4) != 0)
+        return false;
+
+    rDecompressedSize = (Src[4] << 24) | (Src[5] << 16) | (Src[6] << 8) | Src[7];
+    return true;
+}
+
+bool CYaz0InStream::Decompress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize)
+{
+    rOutSize = 0;
+    uint32_t DecompressedSize;
+
+    if (!ReadHeader(Src, DecompressedSize) || Dst.size() < DecompressedSize)
+        return false;
+
+    SDecodeState State;
+    const uint8_t *pkIn = Src.data() + skHeaderSize;
+    const bool Success = DecodeYaz0(State, pkIn, Src.data() + Src.size(), true, Dst.data(), rOutSize, DecompressedSize);
+    return Success && rOutSize == DecompressedSize;
+}
+
+bool CYaz0InStream::Decompress(IInputStream& rSource, uint64_t CompressedSize, std::span<uint8_t> Dst, size_t& rOutSize)
+{
+    // If the compressed data is already in memory, decode it in place
+    size_t NumBuffered = 0;
+    const void* pkBuffered = rSource.BufferedDataAtPosition(NumBuffered);
+
+    if (pkBuffered && NumBuffered >= CompressedSize)
+    {
+        const bool Success = Decompress({static_cast<const uint8_t*>(pkBuffered), static_cast<size_t>(CompressedSize)}, Dst, rOutSize);
+        rSource.Skip(static_cast<int64_t>(CompressedSize));
+        return Success;
+    }
+
+    const uint64_t End = rSource.Tell() + CompressedSize;
+    CYaz0InStream Stream(&rSource, CompressedSize);
+    rOutSize = 0;
+
+    if (!Stream.IsValid() || Dst.size() < Stream.Size())
+    {
+        rSource.GoTo(End);
+        return false;
+    }
+
+    Stream.ReadBytes(Dst.data(), static_cast<size_t>(Stream.Size()));
+    rOutSize = static_cast<size_t>(Stream.Tell());
+    rSource.GoTo(End);
+    return rOutSize == Stream.Size();
+}
+
+// ************ PRIVATE ************
+void CYaz0InStream::Restart()
+{
+    mSourcePos = mSourceStart;
+    mPos = 0;
+    mInputPos = 0;
+    mInputFill = 0;
+    mWindowStart = 0;
+    mWindowFill = 0;
+    mState = SDecodeState();
+    mError = false;
+}
+
+bool CYaz0InStream::FillWindow()
+{
+    if (mError || mWindowStart + mWindowFill >= mDecompressedSize)
+        return false;
+
+    if (mWindow.empty())
+    {
+        mWindow.resize(skWindowSize);
+        mInputBuffer.resize(skInputBufferSize);
+    }
+
+    // Once the window is full, slide it back, keeping enough history for any back-reference
+    if (mWindowFill == mWindow.size())
+    {
+        const uint32_t Discard = mWindowFill - skMaxDistance;
+        std::memmove(mWindow.data(), mWindow.data() + Discard, skMaxDistance);
+        mWindowStart += Discard;
+        mWindowFill = skMaxDistance;
+    }
+
+    const auto OutEnd = static_cast<size_t>(std::min<uint64_t>(mWindow.size(), mDecompressedSize - mWindowStart));
+    const uint32_t OldFill = mWindowFill;
+
+    while (mWindowFill < OutEnd)
+    {
+        // Top up the input buffer, carrying over any partial operation at the end of it
+        if (mInputFill - mInputPos < kMaxOpSize && mSourcePos < mSourceEnd)
+        {
+            const uint32_t NumLeftover = mInputFill - mInputPos;
+            std::memmove(mInputBuffer.data(), mInputBuffer.data() + mInputPos, NumLeftover);
+            mInputPos = 0;
+            mInputFill = NumLeftover;
+
+            // Only reposition the source if something else moved it since our last read
+            if (mpSource->Tell() != mSourcePos)
+                mpSource->GoTo(mSourcePos);
+
+            const auto NumToRead = static_cast<size_t>(std::min<uint64_t>(mInputBuffer.size() - NumLeftover, mSourceEnd - mSourcePos));
+            mpSource->ReadBytes(mInputBuffer.data() + NumLeftover, NumToRead);
+            const uint64_t NumRead = mpSource->Tell() - mSourcePos;
+            mSourcePos += NumRead;
+            mInputFill += static_cast<uint32_t>(NumRead);
+
+            // Treat a short read as the end of the data so the decoder can report truncation
+            if (NumRead < NumToRead)
+                mSourceEnd = mSourcePos;
+        }
+
+        const uint8_t *pkIn = mInputBuffer.data() + mInputPos;
+        size_t OutPos = mWindowFill;
+        const bool Success = DecodeYaz0(mState, pkIn, mInputBuffer.data() + mInputFill, mSourcePos >= mSourceEnd,
+                                        mWindow.data(), OutPos, OutEnd);
+
+        const bool MadeProgress = (OutPos != mWindowFill);
+        mInputPos = static_cast<uint32_t>(pkIn - mInputBuffer.data());
+        mWindowFill = static_cast<uint32_t>(OutPos);
+
+        if (!Success || (!MadeProgress && mSourcePos >= mSourceEnd))
+        {
+            NLog::Error("{}: Invalid or truncated Yaz0 data", mDataSource);
+            mError = true;
+            break;
+        }
+    }
+
+    return mWindowFill > OldFill;
+}
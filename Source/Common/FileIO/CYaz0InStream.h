@@ -0,0 +1,88 @@
+#ifndef AXIO_CYAZ0INSTREAM_H
+#define AXIO_CYAZ0INSTREAM_H
+
+#include "IInputStream.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Decompresses Yaz0, the LZ77 variant Nintendo uses to wrap many of its file formats.
+// The stream reads the Yaz0 header at the source's current position and decodes on demand
+// into a sliding window, so arbitrarily large files can be read incrementally.
+// Seeking forward decodes and discards; seeking backward past the window restarts from the beginning.
+class CYaz0InStream : public IInputStream
+{
+public:
+    // Decoder position that carries over between calls when decoding incrementally
+    struct SDecodeState
+    {
+        uint32_t CodeByte = 0;
+        uint32_t NumCodeBits = 0;
+        uint32_t MatchDist = 0;
+        uint32_t MatchLen = 0;
+    };
+
+private:
+    IInputStream *mpSource = nullptr;
+    uint64_t mSourceStart = 0;      // Offset of the first byte after the header
+    uint64_t mSourcePos = 0;
+    uint64_t mSourceEnd = 0;
+    uint64_t mDecompressedSize = 0;
+    uint64_t mPos = 0;
+
+    std::vector<uint8_t> mInputBuffer;
+    uint32_t mInputPos = 0;
+    uint32_t mInputFill = 0;
+
+    // Decoded data, preceded by enough history to resolve back-references
+    std::vector<uint8_t> mWindow;
+    uint64_t mWindowStart = 0;
+    uint32_t mWindowFill = 0;
+
+    SDecodeState mState;
+    bool mError = false;
+
+public:
+    static constexpr uint32_t skHeaderSize = 0x10;
+    static constexpr uint32_t skMaxDistance = 0x1000;
+    static constexpr uint32_t skInputBufferSize = 0x10000;
+    static constexpr uint32_t skWindowSize = skMaxDistance + 0x10000;
+
+    CYaz0InStream();
+    explicit CYaz0InStream(IInputStream *pSource, uint64_t CompressedSize);
+    ~CYaz0InStream() override;
+
+    CYaz0InStream(const CYaz0InStream&) = delete;
+    CYaz0InStream& operator=(const CYaz0InStream&) = delete;
+
+    /** Reads the Yaz0 header at the source stream's current position and starts decompressing */
+    void Open(IInputStream *pSource, uint64_t CompressedSize);
+    void Close();
+
+    void ReadBytes(void* pDst, size_t Count) override;
+    bool Seek(int64_t Offset, uint32_t Origin) override;
+    uint64_t Tell() const override;
+    bool EoF() const override;
+    bool IsValid() const override;
+    uint64_t Size() const override;
+
+    /** Checks for the Yaz0 magic and returns the decompressed size from the header */
+    static bool ReadHeader(std::span<const uint8_t> Src, uint32_t& rDecompressedSize);
+
+    /**
+     * Decompresses a complete Yaz0 file (including its header) from Src into Dst.
+     * rOutSize receives the number of bytes written. Returns false on corrupt input
+     * or if Dst is smaller than the size in the header.
+     */
+    static bool Decompress(std::span<const uint8_t> Src, std::span<uint8_t> Dst, size_t& rOutSize);
+
+    /** Decompresses CompressedSize bytes from the stream's current position into Dst */
+    static bool Decompress(IInputStream& rSource, uint64_t CompressedSize, std::span<uint8_t> Dst, size_t& rOutSize);
+
+private:
+    void Restart();
+    bool FillWindow();
+};
+
+#endif // AXIO_CYAZ0INSTREAM_H
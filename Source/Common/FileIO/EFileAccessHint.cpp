@@ -0,0 +1,118 @@
+#include "EFileAccessHint.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && __has_include(<stdio_ext.h>)
+#include <stdio_ext.h>
+#define AXIO_HAS_FSETLOCKING 1
+#endif
+
+bool AdviseFileAccess(FILE *pFile, EFileAccessHint Hint, uint64_t Offset /*= 0*/, uint64_t Length /*= 0*/)
+{
+    if (!pFile)
+        return false;
+
+#if defined(_WIN32)
+    // Windows only takes access hints when the file is opened
+    (void) Hint;
+    (void) Offset;
+    (void) Length;
+    return false;
+#elif defined(__APPLE__)
+    // No fadvise; readahead can only be switched on or off for the whole file
+    (void) Offset;
+    (void) Length;
+    const int FileDesc = fileno(pFile);
+
+    switch (Hint)
+    {
+        case EFileAccessHint::Normal:
+        case EFileAccessHint::Sequential:
+            return fcntl(FileDesc, F_RDAHEAD, 1) != -1;
+        case EFileAccessHint::Random:
+            return fcntl(FileDesc, F_RDAHEAD, 0) != -1;
+        default:
+            return false;
+    }
+#else
+    int Advice;
+
+    switch (Hint)
+    {
+        case EFileAccessHint::Normal:       Advice = POSIX_FADV_NORMAL;     break;
+        case EFileAccessHint::Sequential:   Advice = POSIX_FADV_SEQUENTIAL; break;
+        case EFileAccessHint::Random:       Advice = POSIX_FADV_RANDOM;     break;
+        case EFileAccessHint::WillNeed:     Advice = POSIX_FADV_WILLNEED;   break;
+        case EFileAccessHint::DontNeed:     Advice = POSIX_FADV_DONTNEED;   break;
+        default:                            return false;
+    }
+
+    return posix_fadvise(fileno(pFile), static_cast<off_t>(Offset), static_cast<off_t>(Length), Advice) == 0;
+#endif
+}
+
+bool AdviseMappedAccess(const void *pkData, size_t Size, EFileAccessHint Hint)
+{
+    if (!pkData || Size == 0)
+        return false;
+
+#ifdef _WIN32
+    (void) Hint;
+    return false;
+#else
+    // madvise wants a page-aligned start
+    static const uintptr_t skPageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    const auto Start = reinterpret_cast<uintptr_t>(pkData);
+    const uintptr_t AlignedStart = Start & ~skPageMask;
+    int Advice;
+
+    switch (Hint)
+    {
+        case EFileAccessHint::Normal:       Advice = MADV_NORMAL;       break;
+        case EFileAccessHint::Sequential:   Advice = MADV_SEQUENTIAL;   break;
+        case EFileAccessHint::Random:       Advice = MADV_RANDOM;       break;
+        case EFileAccessHint::WillNeed:     Advice = MADV_WILLNEED;     break;
+        case EFileAccessHint::DontNeed:     Advice = MADV_DONTNEED;     break;
+        default:                            return false;
+    }
+
+    return madvise(reinterpret_cast<void*>(AlignedStart), Size + (Start - AlignedStart), Advice) == 0;
+#endif
+}
+
+bool DropFileCache(FILE *pFile)
+{
+    if (!pFile || fflush(pFile) != 0)
+        return false;
+
+#if defined(_WIN32) || defined(__APPLE__)
+    // Neither can evict a file's pages after the fact
+    return true;
+#else
+    // Dirty pages can't be dropped, so they have to reach the disk first
+    const int FileDesc = fileno(pFile);
+#ifdef __linux__
+    if (sync_file_range(FileDesc, 0, 0, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) != 0)
+        return false;
+#else
+    if (fdatasync(FileDesc) != 0)
+        return false;
+#endif
+    posix_fadvise(FileDesc, 0, 0, POSIX_FADV_DONTNEED);
+    return true;
+#endif
+}
+
+void SetStdioLocking(FILE *pFile, bool Unlocked)
+{
+#ifdef AXIO_HAS_FSETLOCKING
+    __fsetlocking(pFile, Unlocked ? FSETLOCKING_BYCALLER : FSETLOCKING_INTERNAL);
+#else
+    (void) pFile;
+    (void) Unlocked;
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef AXIO_EFILEACCESSHINT_H
+#define AXIO_EFILEACCESSHINT_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Tells the OS how a file is about to be used, so it can tune readahead and page caching.
+// Purely advisory; platforms that have no equivalent ignore it.
+enum class EFileAccessHint
+{
+    Normal,         // Default readahead
+    Sequential,     // Read front to back; read ahead aggressively
+    Random,         // Scattered reads; don't bother reading ahead
+    WillNeed,       // Start loading the range into the page cache now
+    DontNeed        // Done with the range; its cached pages can be dropped
+};
+
+// Advise the OS about a byte range of an open file, or of a memory mapping. A Length of 0 runs to
+// the end of the file. Returns false if the platform has no way to act on the hint.
+bool AdviseFileAccess(FILE *pFile, EFileAccessHint Hint, uint64_t Offset = 0, uint64_t Length = 0);
+bool AdviseMappedAccess(const void *pkData, size_t Size, EFileAccessHint Hint);
+
+// Writes back any dirty pages of the file and evicts the file from the page cache. Returns false
+// if the data couldn't be written back; the eviction itself is only advisory.
+bool DropFileCache(FILE *pFile);
+
+// Turns the stdio lock of a file on or off for every later call. Only glibc and musl can do this;
+// the Windows CRT has no such switch, so callers use the _nolock variants there instead.
+// Elsewhere this does nothing.
+void SetStdioLocking(FILE *pFile, bool Unlocked);
+
+#endif // AXIO_EFILEACCESSHINT_H
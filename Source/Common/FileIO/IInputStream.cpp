@@ -5,6 +5,44 @@
 
 #include <bit>
 #include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+/** Returns the index of the first zero 16-bit unit in the buffer, or NumChars if there isn't one */
+size_t Find16BitTerminator(const char *pkData, size_t NumChars)
+{
+    size_t Idx = 0;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    const __m128i Zero = _mm_setzero_si128();
+
+    for (; Idx + 8 <= NumChars; Idx += 8)
+    {
+        const __m128i Chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pkData + (Idx * 2)));
+        const auto Mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(Chars, Zero)));
+
+        if (Mask != 0)
+            return Idx + (std::countr_zero(Mask) / 2);
+    }
+#endif
+
+    for (; Idx < NumChars; Idx++)
+    {
+        if (pkData[Idx * 2] == 0 && pkData[(Idx * 2) + 1] == 0)
+            break;
+    }
+
+    return Idx;
+}
+
+} // anonymous namespace
 
 IInputStream::~IInputStream() = default;
 
@@ -107,15 +145,36 @@ CFourCC IInputStream::ReadFourCC()
 TString IInputStream::ReadString()
 {
     TString Str;
-    char Chr;
 
-    do
+    while (true)
     {
-        Chr = ReadS8();
-        if (Chr != 0)
-            Str.Append(Chr);
+        // Fast path: scan whatever is already buffered for the terminator
+        size_t NumBuffered = 0;
+        const auto* pkBuffered = static_cast<const char*>(BufferedDataAtPosition(NumBuffered));
+
+        if (pkBuffered && NumBuffered > 0)
+        {
+            const auto* pkTerminator = static_cast<const char*>(memchr(pkBuffered, 0, NumBuffered));
+            const auto Length = static_cast<size_t>(pkTerminator ? pkTerminator - pkBuffered : NumBuffered);
+            Str.Append(std::string_view(pkBuffered, Length));
+            Skip(static_cast<int64_t>(pkTerminator ? Length + 1 : Length));
+
+            if (pkTerminator || EoF())
+                break;
+
+            continue;
+        }
+
+        // Slow path: nothing buffered, so read a single character (which may refill the buffer)
+        const char Chr = ReadS8();
+        if (Chr == 0)
+            break;
+
+        Str.Append(Chr);
+
+        if (EoF())
+            break;
     }
-    while (Chr != 0 && !EoF());
 
     return Str;
 }
@@ -136,15 +195,49 @@ TString IInputStream::ReadSizedString()
 T16String IInputStream::Read16String()
 {
     T16String Out;
-    char16_t Chr = 1;
 
-    do
+    while (true)
     {
-        Chr = ReadS16();
-        if (Chr != 0)
-            Out.Append(Chr);
+        // Fast path: scan whatever is already buffered for the terminator
+        size_t NumBuffered = 0;
+        const auto* pkBuffered = static_cast<const char*>(BufferedDataAtPosition(NumBuffered));
+        const size_t NumChars = NumBuffered / sizeof(char16_t);
+
+        if (pkBuffered && NumChars > 0)
+        {
+            const size_t Length = Find16BitTerminator(pkBuffered, NumChars);
+            const bool FoundTerminator = (Length < NumChars);
+
+            // The buffer may not be 2-byte aligned, so copy into place rather than viewing it in place
+            T16String Chunk(Length, u'\0');
+            memcpy(Chunk.data(), pkBuffered, Length * sizeof(char16_t));
+
+            if (mDataEndianness != std::endian::native)
+                NByteSwap::SwapArray(Chunk.data(), Length);
+
+            if (Out.IsEmpty())
+                Out = std::move(Chunk);
+            else
+                Out.Append(std::u16string_view(Chunk.data(), Chunk.Size()));
+
+            Skip(static_cast<int64_t>((FoundTerminator ? Length + 1 : Length) * sizeof(char16_t)));
+
+            if (FoundTerminator || EoF())
+                break;
+
+            continue;
+        }
+
+        // Slow path: nothing buffered, so read a single character (which may refill the buffer)
+        const auto Chr = static_cast<char16_t>(ReadS16());
+        if (Chr == 0)
+            break;
+
+        Out.Append(Chr);
+
+        if (EoF())
+            break;
     }
-    while (Chr != 0 && !EoF());
 
     return Out;
 }
@@ -167,6 +260,18 @@ T16String IInputStream::ReadSized16String()
     return Read16String(StringSize);
 }
 
+void IInputStream::ReadArray(void *pDst, size_t Count, size_t ElemSize)
+{
+    switch (ElemSize)
+    {
+    case 1: ReadBytes(pDst, Count); break;
+    case 2: ReadArray(static_cast<uint16_t*>(pDst), Count); break;
+    case 4: ReadArray(static_cast<uint32_t*>(pDst), Count); break;
+    case 8: ReadArray(static_cast<uint64_t*>(pDst), Count); break;
+    default: ASSERT(false); break;
+    }
+}
+
 int8_t IInputStream::PeekS8()
 {
     const auto Val = ReadS8();
@@ -236,19 +341,19 @@ CFourCC IInputStream::PeekFourCC()
     return Val;
 }
 
-bool IInputStream::GoTo(uint32_t Address)
+bool IInputStream::GoTo(uint64_t Address)
 {
-    return Seek(Address, SEEK_SET);
+    return Seek(static_cast<int64_t>(Address), SEEK_SET);
 }
 
-bool IInputStream::Skip(int32_t SkipAmount)
+bool IInputStream::Skip(int64_t SkipAmount)
 {
     return Seek(SkipAmount, SEEK_CUR);
 }
 
 void IInputStream::SeekToBoundary(uint32_t Boundary)
 {
-    const uint32_t Num = Boundary - (Tell() % Boundary);
+    const auto Num = static_cast<uint32_t>(Boundary - (Tell() % Boundary));
 
     if (Num == Boundary)
         return;
@@ -276,12 +381,32 @@ const TString& IInputStream::GetSourceString() const
     return mDataSource;
 }
 
-bool IInputStream::Seek64(int64_t Offset, uint32_t Origin)
+uint32_t IInputStream::Tell32() const
+{
+    const uint64_t Pos = Tell();
+    ASSERT(Pos <= UINT32_MAX);
+    return static_cast<uint32_t>(Pos);
+}
+
+uint32_t IInputStream::Size32() const
+{
+    const uint64_t StreamSize = Size();
+    ASSERT(StreamSize <= UINT32_MAX);
+    return static_cast<uint32_t>(StreamSize);
+}
+
+const void* IInputStream::BufferedDataAtPosition(size_t& rOutSize) const
+{
+    rOutSize = 0;
+    return nullptr;
+}
+
+bool IInputStream::SupportsReadAt() const
 {
-    return Seek(static_cast<int32_t>(Offset), Origin);
+    return false;
 }
 
-uint64_t IInputStream::Tell64() const
+size_t IInputStream::ReadAt(uint64_t, void*, size_t) const
 {
-    return static_cast<uint64_t>(Tell());
+    return 0;
 }
@@ -2,6 +2,7 @@
 #define AXIO_IINPUTSTREAM_H
 
 #include "Common/TString.h"
+#include "Common/FileIO/NByteSwap.h"
 
 #include <bit>
 #include <cstdint>
@@ -34,6 +35,19 @@ public:
     T16String Read16String(size_t Count);
     T16String ReadSized16String();
 
+    /** Reads Count elements with a single ReadBytes call, then byteswaps them in one pass if needed */
+    template <ByteSwappable T>
+    void ReadArray(T *pDst, size_t Count)
+    {
+        ReadBytes(pDst, Count * sizeof(T));
+
+        if (sizeof(T) > 1 && mDataEndianness != std::endian::native)
+            NByteSwap::SwapArray(pDst, Count);
+    }
+
+    /** Same as ReadArray, for data whose element size (1, 2, 4 or 8 bytes) is only known at runtime */
+    void ReadArray(void *pDst, size_t Count, size_t ElemSize);
+
     int8_t PeekS8();
     uint8_t PeekU8();
     int16_t PeekS16();
@@ -46,8 +60,8 @@ public:
     double PeekF64();
     CFourCC PeekFourCC();
 
-    bool GoTo(uint32_t Address);
-    bool Skip(int32_t SkipAmount);
+    bool GoTo(uint64_t Address);
+    bool Skip(int64_t SkipAmount);
 
     void SeekToBoundary(uint32_t Boundary);
     void SetEndianness(std::endian Endianness);
@@ -55,15 +69,29 @@ public:
     std::endian GetEndianness() const;
     const TString& GetSourceString() const;
 
+    // 32-bit compatibility; positions and sizes are 64-bit throughout
+    bool Seek64(int64_t Offset, uint32_t Origin)    { return Seek(Offset, Origin); }
+    uint64_t Tell64() const                         { return Tell(); }
+    uint32_t Tell32() const;
+    uint32_t Size32() const;
+
     virtual ~IInputStream();
-    virtual void ReadBytes(void *pDst, uint32_t Count) = 0;
-    virtual bool Seek(int32_t Offset, uint32_t Origin) = 0;
-    virtual bool Seek64(int64_t Offset, uint32_t Origin);
-    virtual uint32_t Tell() const = 0;
-    virtual uint64_t Tell64() const;
+    virtual void ReadBytes(void *pDst, size_t Count) = 0;
+    virtual bool Seek(int64_t Offset, uint32_t Origin) = 0;
+    virtual uint64_t Tell() const = 0;
     virtual bool EoF() const = 0;
     virtual bool IsValid() const = 0;
-    virtual uint32_t Size() const = 0;
+    virtual uint64_t Size() const = 0;
+
+    // Returns the bytes at the current position that are already in memory and can be consumed
+    // without further I/O, or nullptr if there are none. Used for fast scanning (e.g. strings).
+    virtual const void* BufferedDataAtPosition(size_t& rOutSize) const;
+
+    // Reads from an absolute offset without using or moving the cursor, and returns the number of
+    // bytes read. Streams that support it allow any number of threads to call it at once, which
+    // lets several parsers work on different parts of one file; the rest always return 0.
+    virtual bool SupportsReadAt() const;
+    virtual size_t ReadAt(uint64_t Offset, void *pDst, size_t Count) const;
 };
 
 #endif // AXIO_IINPUTSTREAM_H
@@ -121,19 +121,76 @@ void IOutputStream::WriteSized16String(const T16String& rkVal)
         WriteS16(Chr);
 }
 
-bool IOutputStream::GoTo(uint32_t Address)
+void IOutputStream::WriteArray(const void *pkSrc, size_t Count, size_t ElemSize)
 {
-    return Seek(Address, SEEK_SET);
+    switch (ElemSize)
+    {
+    case 1: WriteBytes(pkSrc, Count); break;
+    case 2: WriteArray(static_cast<const uint16_t*>(pkSrc), Count); break;
+    case 4: WriteArray(static_cast<const uint32_t*>(pkSrc), Count); break;
+    case 8: WriteArray(static_cast<const uint64_t*>(pkSrc), Count); break;
+    default: ASSERT(false); break;
+    }
 }
 
-bool IOutputStream::Skip(int32_t SkipAmount)
+uint64_t IOutputStream::ReserveU16()
+{
+    const uint64_t Handle = Tell();
+    WriteU16(0);
+    return Handle;
+}
+
+uint64_t IOutputStream::ReserveU32()
+{
+    const uint64_t Handle = Tell();
+    WriteU32(0);
+    return Handle;
+}
+
+uint64_t IOutputStream::ReserveU64()
+{
+    const uint64_t Handle = Tell();
+    WriteU64(0);
+    return Handle;
+}
+
+void IOutputStream::PatchU16(uint64_t Handle, uint16_t Val)
+{
+    if (mDataEndianness != std::endian::native)
+        Val = std::byteswap(Val);
+
+    PatchBytes(Handle, &Val, sizeof(Val));
+}
+
+void IOutputStream::PatchU32(uint64_t Handle, uint32_t Val)
+{
+    if (mDataEndianness != std::endian::native)
+        Val = std::byteswap(Val);
+
+    PatchBytes(Handle, &Val, sizeof(Val));
+}
+
+void IOutputStream::PatchU64(uint64_t Handle, uint64_t Val)
+{
+    if (mDataEndianness != std::endian::native)
+        Val = std::byteswap(Val);
+
+    PatchBytes(Handle, &Val, sizeof(Val));
+}
+
+bool IOutputStream::GoTo(uint64_t Address)
+{
+    return Seek(static_cast<int64_t>(Address), SEEK_SET);
+}
+
+bool IOutputStream::Skip(int64_t SkipAmount)
 {
     return Seek(SkipAmount, SEEK_CUR);
 }
 
 void IOutputStream::WriteToBoundary(uint32_t Boundary, uint8_t Fill)
 {
-    const auto Num = Boundary - (Tell() % Boundary);
+    const auto Num = static_cast<uint32_t>(Boundary - (Tell() % Boundary));
 
     if (Num == Boundary)
         return;
@@ -152,12 +209,30 @@ std::endian IOutputStream::GetEndianness() const
     return mDataEndianness;
 }
 
-bool IOutputStream::Seek64(int64_t Offset, uint32_t Origin)
+uint32_t IOutputStream::Tell32() const
+{
+    const uint64_t Pos = Tell();
+    ASSERT(Pos <= UINT32_MAX);
+    return static_cast<uint32_t>(Pos);
+}
+
+uint32_t IOutputStream::Size32() const
+{
+    const uint64_t StreamSize = Size();
+    ASSERT(StreamSize <= UINT32_MAX);
+    return static_cast<uint32_t>(StreamSize);
+}
+
+void IOutputStream::PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count)
 {
-    return Seek(static_cast<int32_t>(Offset), Origin);
+    const uint64_t Pos = Tell();
+    GoTo(Offset);
+    WriteBytes(pkSrc, Count);
+    GoTo(Pos);
 }
 
-uint64_t IOutputStream::Tell64() const
+void IOutputStream::WriteGather(std::span<const std::span<const uint8_t>> Buffers)
 {
-    return static_cast<uint64_t>(Tell());
+    for (const std::span<const uint8_t>& rkBuffer : Buffers)
+        WriteBytes(rkBuffer.data(), rkBuffer.size());
 }
@@ -2,8 +2,12 @@
 #define AXIO_IOUTPUTSTREAM_H
 
 #include "Common/TString.h"
+#include "Common/FileIO/NByteSwap.h"
 
+#include <algorithm>
 #include <bit>
+#include <cstdint>
+#include <span>
 
 class CFourCC;
 
@@ -30,21 +34,71 @@ public:
     void Write16String(const T16String& rkVal, int Count = -1, bool Terminate = true);
     void WriteSized16String(const T16String& rkVal);
 
-    bool GoTo(uint32_t Address);
-    bool Skip(int32_t SkipAmount);
+    /** Writes Count elements; data that needs swapping goes through a fixed-size staging buffer */
+    template <ByteSwappable T>
+    void WriteArray(const T *pkSrc, size_t Count)
+    {
+        if (sizeof(T) == 1 || mDataEndianness == std::endian::native)
+        {
+            WriteBytes(pkSrc, Count * sizeof(T));
+            return;
+        }
+
+        constexpr size_t kStagingCount = 0x1000 / sizeof(T);
+        T Staging[kStagingCount];
+
+        while (Count > 0)
+        {
+            const size_t NumElems = std::min(Count, kStagingCount);
+            NByteSwap::SwapCopyArray(Staging, pkSrc, NumElems);
+            WriteBytes(Staging, NumElems * sizeof(T));
+            pkSrc += NumElems;
+            Count -= NumElems;
+        }
+    }
+
+    /** Same as WriteArray, for data whose element size (1, 2, 4 or 8 bytes) is only known at runtime */
+    void WriteArray(const void *pkSrc, size_t Count, size_t ElemSize);
+
+    /**
+     * Deferred fields. Reserve*() writes a zeroed placeholder and returns a handle to it;
+     * Patch*() fills it in later without moving the write position, so the stream itself
+     * is only ever written sequentially.
+     */
+    uint64_t ReserveU16();
+    uint64_t ReserveU32();
+    uint64_t ReserveU64();
+    void PatchU16(uint64_t Handle, uint16_t Val);
+    void PatchU32(uint64_t Handle, uint32_t Val);
+    void PatchU64(uint64_t Handle, uint64_t Val);
+
+    bool GoTo(uint64_t Address);
+    bool Skip(int64_t SkipAmount);
 
     void WriteToBoundary(uint32_t Boundary, uint8_t Fill);
     void SetEndianness(std::endian Endianness);
     std::endian GetEndianness() const;
 
+    // 32-bit compatibility; positions and sizes are 64-bit throughout
+    bool Seek64(int64_t Offset, uint32_t Origin)    { return Seek(Offset, Origin); }
+    uint64_t Tell64() const                         { return Tell(); }
+    uint32_t Tell32() const;
+    uint32_t Size32() const;
+
     virtual ~IOutputStream();
-    virtual void WriteBytes(const void *pkSrc, uint32_t Count) = 0;
-    virtual bool Seek(int32_t Offset, uint32_t Origin) = 0;
-    virtual bool Seek64(int64_t Offset, uint32_t Origin);
-    virtual uint32_t Tell() const = 0;
-    virtual uint64_t Tell64() const;
+    virtual void WriteBytes(const void *pkSrc, size_t Count) = 0;
+    virtual bool Seek(int64_t Offset, uint32_t Origin) = 0;
+    virtual uint64_t Tell() const = 0;
     virtual bool EoF() const = 0;
     virtual bool IsValid() const = 0;
-    virtual uint32_t Size() const = 0;
+    virtual uint64_t Size() const = 0;
+
+    // Overwrites Count bytes at Offset and leaves the write position where it was. The default
+    // implementation seeks there and back; streams that can do better should override it.
+    virtual void PatchBytes(uint64_t Offset, const void *pkSrc, size_t Count);
+
+    // Writes each buffer in turn, the same as calling WriteBytes() on them one after another.
+    // Streams that can hand the whole list to the OS at once, or size themselves once up front, override it.
+    virtual void WriteGather(std::span<const std::span<const uint8_t>> Buffers);
 };
 #endif // AXIO_IOUTPUTSTREAM_H
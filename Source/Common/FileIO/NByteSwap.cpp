@@ -0,0 +1,159 @@
+#include "NByteSwap.h"
+
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define BYTESWAP_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#else
+    #define BYTESWAP_X86 0
+#endif
+
+// GCC/Clang need the instruction set enabled per-function so the library can still be built
+// for baseline x86-64; the actual code path is picked at runtime. MSVC always allows intrinsics.
+#if BYTESWAP_X86 && (defined(__GNUC__) || defined(__clang__))
+    #define TARGET_SSSE3 __attribute__((target("ssse3")))
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define TARGET_SSSE3
+    #define TARGET_AVX2
+#endif
+
+namespace
+{
+
+template <typename T>
+void SwapScalar(uint8_t *pDst, const uint8_t *pkSrc, size_t Count)
+{
+    for (size_t i = 0; i < Count; i++)
+    {
+        T Val;
+        memcpy(&Val, pkSrc + (i * sizeof(T)), sizeof(T));
+        Val = std::byteswap(Val);
+        memcpy(pDst + (i * sizeof(T)), &Val, sizeof(T));
+    }
+}
+
+#if BYTESWAP_X86
+enum class ESwapPath
+{
+    Scalar,
+    SSSE3,
+    AVX2
+};
+
+ESwapPath DetectSwapPath()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int Info[4];
+    __cpuid(Info, 0);
+    const int MaxLeaf = Info[0];
+
+    __cpuid(Info, 1);
+    const bool HasSSSE3 = (Info[2] & (1 << 9)) != 0;
+    const bool HasOSXSave = (Info[2] & (1 << 27)) != 0;
+    const bool HasAVX = (Info[2] & (1 << 28)) != 0;
+
+    // AVX2 also requires the OS to save YMM state on context switches
+    if (MaxLeaf >= 7 && HasOSXSave && HasAVX && (_xgetbv(0) & 0x6) == 0x6)
+    {
+        __cpuidex(Info, 7, 0);
+        if ((Info[1] & (1 << 5)) != 0)
+            return ESwapPath::AVX2;
+    }
+
+    return HasSSSE3 ? ESwapPath::SSSE3 : ESwapPath::Scalar;
+#else
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return ESwapPath::AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+        return ESwapPath::SSSE3;
+
+    return ESwapPath::Scalar;
+#endif
+}
+
+ESwapPath GetSwapPath()
+{
+    static const ESwapPath skPath = DetectSwapPath();
+    return skPath;
+}
+
+// pshufb masks that reverse the bytes of each 2/4/8-byte lane
+alignas(16) constexpr uint8_t gkSwapMask16[16] = { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+alignas(16) constexpr uint8_t gkSwapMask32[16] = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+alignas(16) constexpr uint8_t gkSwapMask64[16] = { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 };
+
+/** Swaps whole 16-byte blocks; returns the number of bytes processed */
+TARGET_SSSE3 size_t SwapSSSE3(uint8_t *pDst, const uint8_t *pkSrc, size_t NumBytes, const uint8_t *pkMask)
+{
+    const __m128i Mask = _mm_load_si128(reinterpret_cast<const __m128i*>(pkMask));
+    size_t Offset = 0;
+
+    for (; Offset + 16 <= NumBytes; Offset += 16)
+    {
+        const __m128i Val = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pkSrc + Offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + Offset), _mm_shuffle_epi8(Val, Mask));
+    }
+
+    return Offset;
+}
+
+/** Swaps whole 32-byte blocks; returns the number of bytes processed */
+TARGET_AVX2 size_t SwapAVX2(uint8_t *pDst, const uint8_t *pkSrc, size_t NumBytes, const uint8_t *pkMask)
+{
+    const __m256i Mask = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(pkMask)));
+    size_t Offset = 0;
+
+    for (; Offset + 32 <= NumBytes; Offset += 32)
+    {
+        const __m256i Val = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pkSrc + Offset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + Offset), _mm256_shuffle_epi8(Val, Mask));
+    }
+
+    return Offset;
+}
+#endif
+
+template <typename T>
+void SwapCopy(void *pDst, const void *pkSrc, size_t Count, [[maybe_unused]] const uint8_t *pkMask)
+{
+    auto* pOut = static_cast<uint8_t*>(pDst);
+    const auto* pkIn = static_cast<const uint8_t*>(pkSrc);
+    const size_t NumBytes = Count * sizeof(T);
+    size_t Done = 0;
+
+#if BYTESWAP_X86
+    const ESwapPath Path = GetSwapPath();
+
+    if (Path == ESwapPath::AVX2)
+        Done = SwapAVX2(pOut, pkIn, NumBytes, pkMask);
+
+    if (Path != ESwapPath::Scalar)
+        Done += SwapSSSE3(pOut + Done, pkIn + Done, NumBytes - Done, pkMask);
+#endif
+
+    SwapScalar<T>(pOut + Done, pkIn + Done, (NumBytes - Done) / sizeof(T));
+}
+
+} // anonymous namespace
+
+namespace NByteSwap
+{
+
+#if BYTESWAP_X86
+void SwapCopy16(void *pDst, const void *pkSrc, size_t Count) { SwapCopy<uint16_t>(pDst, pkSrc, Count, gkSwapMask16); }
+void SwapCopy32(void *pDst, const void *pkSrc, size_t Count) { SwapCopy<uint32_t>(pDst, pkSrc, Count, gkSwapMask32); }
+void SwapCopy64(void *pDst, const void *pkSrc, size_t Count) { SwapCopy<uint64_t>(pDst, pkSrc, Count, gkSwapMask64); }
+#else
+void SwapCopy16(void *pDst, const void *pkSrc, size_t Count) { SwapCopy<uint16_t>(pDst, pkSrc, Count, nullptr); }
+void SwapCopy32(void *pDst, const void *pkSrc, size_t Count) { SwapCopy<uint32_t>(pDst, pkSrc, Count, nullptr); }
+void SwapCopy64(void *pDst, const void *pkSrc, size_t Count) { SwapCopy<uint64_t>(pDst, pkSrc, Count, nullptr); }
+#endif
+
+} // namespace NByteSwap
@@ -0,0 +1,47 @@
+#ifndef AXIO_NBYTESWAP_H
+#define AXIO_NBYTESWAP_H
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/** Types that can be read/written in bulk and byteswapped element-wise */
+template <typename T>
+concept ByteSwappable = (std::integral<T> || std::floating_point<T>) && !std::same_as<T, bool> &&
+                        (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+/**
+ * Bulk byteswapping of arrays. On x86 these use SSSE3/AVX2 shuffles when the CPU supports them
+ * (detected at runtime) and fall back to a scalar loop otherwise. Source and destination may be
+ * the same buffer, but may not otherwise overlap.
+ */
+namespace NByteSwap
+{
+
+void SwapCopy16(void *pDst, const void *pkSrc, size_t Count);
+void SwapCopy32(void *pDst, const void *pkSrc, size_t Count);
+void SwapCopy64(void *pDst, const void *pkSrc, size_t Count);
+
+template <ByteSwappable T>
+void SwapCopyArray(T *pDst, const T *pkSrc, size_t Count)
+{
+    if constexpr (sizeof(T) == 2)
+        SwapCopy16(pDst, pkSrc, Count);
+    else if constexpr (sizeof(T) == 4)
+        SwapCopy32(pDst, pkSrc, Count);
+    else if constexpr (sizeof(T) == 8)
+        SwapCopy64(pDst, pkSrc, Count);
+    else if (pDst != pkSrc)
+        std::memcpy(pDst, pkSrc, Count);
+}
+
+template <ByteSwappable T>
+void SwapArray(T *pData, size_t Count)
+{
+    SwapCopyArray(pData, pData, Count);
+}
+
+} // namespace NByteSwap
+
+#endif // AXIO_NBYTESWAP_H
@@ -0,0 +1,248 @@
+#ifndef AXIO_TFASTREADER_H
+#define AXIO_TFASTREADER_H
+
+#include "Common/CFourCC.h"
+#include "Common/Macros.h"
+#include "Common/TString.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+/**
+ * Non-virtual read cursor over a contiguous block of memory, such as the contents of a
+ * CMemoryInStream or CMappedFileInStream. The data endianness is a template parameter, so
+ * every read compiles down to a load plus (if needed) a byteswap, which makes this suitable
+ * for hot loops that read vertex/index buffers value by value. It exposes the same Read/Peek
+ * vocabulary as IInputStream so parsers can switch between the two with minimal changes.
+ *
+ * Reads are bounds checked with ASSERT, so the checks are compiled out of public release builds.
+ * The reader does not own the memory it reads from.
+ */
+template <std::endian Endian>
+class TFastReader
+{
+    const uint8_t *mpStart = nullptr;
+    const uint8_t *mpCur = nullptr;
+    const uint8_t *mpEnd = nullptr;
+
+public:
+    constexpr TFastReader() = default;
+
+    TFastReader(const void *pkData, size_t Size)
+        : mpStart(static_cast<const uint8_t*>(pkData))
+        , mpCur(mpStart)
+        , mpEnd(mpStart + Size)
+    {}
+
+    explicit TFastReader(std::span<const uint8_t> Data)
+        : TFastReader(Data.data(), Data.size())
+    {}
+
+    /** Construct from any memory-backed stream; the cursor starts at the stream's current position */
+    template <typename StreamT>
+    requires requires(const StreamT& rkStream) { rkStream.Data(); rkStream.Size(); rkStream.Tell(); }
+    explicit TFastReader(const StreamT& rkStream)
+        : TFastReader(rkStream.Data(), rkStream.Size())
+    {
+        GoTo(rkStream.Tell());
+    }
+
+    // Primitive reads
+    bool ReadBool()         { return Load<uint8_t>() != 0; }
+    int8_t ReadS8()         { return Load<int8_t>(); }
+    uint8_t ReadU8()        { return Load<uint8_t>(); }
+    int16_t ReadS16()       { return Load<int16_t>(); }
+    uint16_t ReadU16()      { return Load<uint16_t>(); }
+    int32_t ReadS32()       { return Load<int32_t>(); }
+    uint32_t ReadU32()      { return Load<uint32_t>(); }
+    int64_t ReadS64()       { return Load<int64_t>(); }
+    uint64_t ReadU64()      { return Load<uint64_t>(); }
+    float ReadF32()         { return Load<float>(); }
+    double ReadF64()        { return Load<double>(); }
+
+    CFourCC ReadFourCC()
+    {
+        // FourCCs are always stored big endian, regardless of the data endianness
+        auto Val = LoadRaw<uint32_t>();
+        if constexpr (std::endian::native == std::endian::little)
+            Val = std::byteswap(Val);
+        return CFourCC(Val);
+    }
+
+    // Peeks
+    int8_t PeekS8()         { return Peek<int8_t>(); }
+    uint8_t PeekU8()        { return Peek<uint8_t>(); }
+    int16_t PeekS16()       { return Peek<int16_t>(); }
+    uint16_t PeekU16()      { return Peek<uint16_t>(); }
+    int32_t PeekS32()       { return Peek<int32_t>(); }
+    uint32_t PeekU32()      { return Peek<uint32_t>(); }
+    int64_t PeekS64()       { return Peek<int64_t>(); }
+    uint64_t PeekU64()      { return Peek<uint64_t>(); }
+    float PeekF32()         { return Peek<float>(); }
+    double PeekF64()        { return Peek<double>(); }
+
+    CFourCC PeekFourCC()
+    {
+        const auto* pkPrev = mpCur;
+        const auto Val = ReadFourCC();
+        mpCur = pkPrev;
+        return Val;
+    }
+
+    // Strings
+    TString ReadString()
+    {
+        // Reads up to and including the terminator; an unterminated string runs to the end of the data
+        const auto* pkTerminator = static_cast<const uint8_t*>(memchr(mpCur, 0, Remaining()));
+        const auto* pkStrEnd = pkTerminator ? pkTerminator : mpEnd;
+        TString Str(reinterpret_cast<const char*>(mpCur), static_cast<size_t>(pkStrEnd - mpCur));
+        mpCur = pkTerminator ? pkTerminator + 1 : mpEnd;
+        return Str;
+    }
+
+    TString ReadString(size_t Count)
+    {
+        CheckRemaining(Count);
+        TString Str(reinterpret_cast<const char*>(mpCur), Count);
+        mpCur += Count;
+        return Str;
+    }
+
+    TString ReadSizedString()
+    {
+        const auto StringSize = ReadU32();
+        return ReadString(StringSize);
+    }
+
+    T16String Read16String()
+    {
+        T16String Out;
+
+        while (Remaining() >= sizeof(char16_t))
+        {
+            const auto Chr = static_cast<char16_t>(ReadU16());
+            if (Chr == 0)
+                break;
+            Out.Append(Chr);
+        }
+
+        return Out;
+    }
+
+    T16String Read16String(size_t Count)
+    {
+        T16String Out(Count, 0);
+
+        for (size_t i = 0; i < Count; i++)
+            Out[i] = static_cast<char16_t>(ReadU16());
+
+        return Out;
+    }
+
+    T16String ReadSized16String()
+    {
+        const auto StringSize = ReadU32();
+        return Read16String(StringSize);
+    }
+
+    // Raw data
+    void ReadBytes(void *pDst, size_t Count)
+    {
+        CheckRemaining(Count);
+        memcpy(pDst, mpCur, Count);
+        mpCur += Count;
+    }
+
+    /** Returns a view of the next Count bytes and advances past them, without copying */
+    std::span<const uint8_t> ReadSpan(size_t Count)
+    {
+        CheckRemaining(Count);
+        std::span<const uint8_t> Out(mpCur, Count);
+        mpCur += Count;
+        return Out;
+    }
+
+    // Positioning
+    bool GoTo(size_t Address)
+    {
+        if (Address > Size())
+            return false;
+
+        mpCur = mpStart + Address;
+        return true;
+    }
+
+    bool Skip(ptrdiff_t SkipAmount)
+    {
+        return GoTo(Tell() + SkipAmount);
+    }
+
+    void SeekToBoundary(size_t Boundary)
+    {
+        const size_t Num = Boundary - (Tell() % Boundary);
+
+        if (Num != Boundary)
+            Skip(Num);
+    }
+
+    size_t Tell() const                     { return static_cast<size_t>(mpCur - mpStart); }
+    size_t Size() const                     { return static_cast<size_t>(mpEnd - mpStart); }
+    size_t Remaining() const                { return static_cast<size_t>(mpEnd - mpCur); }
+    bool EoF() const                        { return mpCur >= mpEnd; }
+    bool IsValid() const                    { return mpStart != nullptr; }
+    const void* Data() const                { return mpStart; }
+    const void* DataAtPosition() const      { return mpCur; }
+    static constexpr std::endian GetEndianness() { return Endian; }
+
+private:
+    void CheckRemaining([[maybe_unused]] size_t Count) const
+    {
+        ASSERT(Count <= Remaining());
+    }
+
+    template <typename T>
+    T LoadRaw()
+    {
+        CheckRemaining(sizeof(T));
+        T Val;
+        memcpy(&Val, mpCur, sizeof(T));
+        mpCur += sizeof(T);
+        return Val;
+    }
+
+    template <typename T>
+    T Load()
+    {
+        if constexpr (sizeof(T) == 1 || Endian == std::endian::native)
+        {
+            return LoadRaw<T>();
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            using IntType = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+            return std::bit_cast<T>(std::byteswap(LoadRaw<IntType>()));
+        }
+        else
+        {
+            return std::byteswap(LoadRaw<T>());
+        }
+    }
+
+    template <typename T>
+    T Peek()
+    {
+        const auto* pkPrev = mpCur;
+        const auto Val = Load<T>();
+        mpCur = pkPrev;
+        return Val;
+    }
+};
+
+using CFastReaderBE = TFastReader<std::endian::big>;
+using CFastReaderLE = TFastReader<std::endian::little>;
+
+#endif // AXIO_TFASTREADER_H
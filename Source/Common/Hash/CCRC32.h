@@ -37,6 +37,22 @@ public:
 
     static uint32_t StaticHashString(std::string_view str);
     static uint32_t StaticHashData(const void* pkData, size_t Size);
+
+    /** Same result as StaticHashString, but usable in constant expressions */
+    static constexpr uint32_t ConstHashString(std::string_view str)
+    {
+        uint32_t Hash = 0xFFFFFFFF;
+
+        for (const char Chr : str)
+        {
+            Hash ^= static_cast<uint8_t>(Chr);
+
+            for (int Bit = 0; Bit < 8; Bit++)
+                Hash = (Hash >> 1) ^ (0xEDB88320 & (0U - (Hash & 1)));
+        }
+
+        return Hash;
+    }
 };
 
 #endif // AXIO_CCRC32_H
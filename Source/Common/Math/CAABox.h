@@ -16,6 +16,8 @@ class CAABox
     CVector3f mMax{-CVector3f::Infinite()};
 
 public:
+    using BulkSerialComponent = float;
+
     constexpr CAABox() = default;
     constexpr CAABox(const CVector3f& min, const CVector3f& max) : mMin{min}, mMax{max} {}
     explicit CAABox(IInputStream& rInput);
@@ -23,6 +23,8 @@ public:
     float Y = 0.0f;
     float Z = 0.0f;
 
+    using BulkSerialComponent = float;
+
     constexpr CVector3f() = default;
     constexpr CVector3f(float XYZ) : X{XYZ}, Y{XYZ}, Z{XYZ} {}
     constexpr CVector3f(float X_, float Y_, float Z_) : X{X_}, Y{Y_}, Z{Z_} {}
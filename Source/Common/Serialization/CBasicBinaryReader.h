@@ -68,6 +68,7 @@ public:
     bool PreSerializePointer(void*& Pointer, uint32_t Flags) override                     { return ArchiveVersion() >= eArVer_Refactor ? mpStream->ReadBool() : true; }
     virtual void SerializeContainerSize(uint32_t& rSize, const TString&, uint32_t Flags)  { SerializePrimitive(rSize, Flags); }
     void SerializeBulkData(void* pData, uint32_t Size, uint32_t Flags) override           { mpStream->ReadBytes(pData, Size); }
+    void SerializeBulkArray(void* pData, size_t Count, uint32_t ComponentSize, uint32_t Flags) override { mpStream->ReadArray(pData, Count, ComponentSize); }
 
     void SerializePrimitive(bool& rValue, uint32_t Flags) override     { rValue = mpStream->ReadBool(); }
     void SerializePrimitive(char& rValue, uint32_t Flags) override     { rValue = mpStream->ReadS8(); }
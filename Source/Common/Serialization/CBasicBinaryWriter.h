@@ -20,7 +20,7 @@ public:
         : mMagic(Magic)
     {
         mArchiveFlags = AF_Binary | AF_Writer | AF_NoSkipping;
-        mpStream = new CFileOutStream(rkFilename, std::endian::big);
+        mpStream = new CFileOutStream(rkFilename, std::endian::big, CFileOutStream::skDefaultBufferSize);
 
         if (mpStream->IsValid())
         {
@@ -53,8 +53,7 @@ public:
         // Write magic and delete stream
         if (mOwnsStream)
         {
-            mpStream->GoTo(0);
-            mpStream->WriteU32(mMagic);
+            mpStream->PatchU32(0, mMagic);
             delete mpStream;
         }
     }
@@ -94,6 +93,7 @@ public:
     void SerializePrimitive(CFourCC& rValue, uint32_t Flags) override  { rValue.Write(*mpStream); }
     void SerializePrimitive(CAssetID& rValue, uint32_t Flags) override { rValue.Write(*mpStream, CAssetID::GameIDLength(Game())); }
     void SerializeBulkData(void* pData, uint32_t Size, uint32_t Flags) override { mpStream->WriteBytes(pData, Size); }
+    void SerializeBulkArray(void* pData, size_t Count, uint32_t ComponentSize, uint32_t Flags) override { mpStream->WriteArray(pData, Count, ComponentSize); }
 };
 
 #endif // CBASICBINARYWRITER
@@ -6,17 +6,31 @@
 #include "Common/Serialization/IArchive.h"
 #include "Common/Serialization/CSerialVersion.h"
 
+#include <algorithm>
+
 class CBinaryReader : public IArchive
 {
     struct SBinaryParm
     {
-        uint32_t Offset;
+        uint64_t Offset;
         uint32_t Size;
         uint32_t NumChildren;
         uint32_t ChildIndex;
+        bool HasChildIndex;
     };
     std::vector<SBinaryParm> mBinaryParmStack;
 
+    // Children of a parameter sorted by ID, built the first time a child is requested out of order.
+    // Indexed by stack depth; the vectors are kept around so later parents can reuse their storage.
+    struct SChildEntry
+    {
+        uint32_t ID;
+        uint32_t ChildIndex;
+        uint64_t Offset;
+        uint32_t Size;
+    };
+    std::vector<std::vector<SChildEntry>> mChildIndices;
+
     IInputStream *mpStream = nullptr;
     bool mMagicValid = false;
     bool mOwnsStream = false;
@@ -74,10 +88,42 @@ private:
         const auto Size = ReadSize();
         const auto Offset = mpStream->Tell();
         const auto NumChildren = ReadSize();
-        mBinaryParmStack.push_back(SBinaryParm{Offset, Size, NumChildren, 0});
+        mBinaryParmStack.push_back(SBinaryParm{Offset, Size, NumChildren, 0, false});
         mBinaryParmStack.reserve(20);
     }
 
+    void BuildChildIndex(size_t Depth)
+    {
+        if (mChildIndices.size() <= Depth)
+            mChildIndices.resize(Depth + 1);
+
+        std::vector<SChildEntry>& rIndex = mChildIndices[Depth];
+        rIndex.clear();
+
+        // The parameter's data starts with the child count, followed by the children themselves
+        const SBinaryParm& rkParent = mBinaryParmStack[Depth];
+        const uint64_t ParentEnd = rkParent.Offset + rkParent.Size;
+        mpStream->GoTo(rkParent.Offset + (mArchiveVersion < eArVer_32BitBinarySize ? 2 : 4));
+
+        for (uint32_t ChildIdx = 0; ChildIdx < rkParent.NumChildren; ChildIdx++)
+        {
+            const auto ChildID = mpStream->ReadU32();
+            const auto ChildSize = ReadSize();
+            const auto ChildOffset = mpStream->Tell();
+
+            if (ChildOffset + ChildSize > ParentEnd)
+                break;
+
+            rIndex.push_back(SChildEntry{ChildID, ChildIdx, ChildOffset, ChildSize});
+            mpStream->Skip(ChildSize);
+        }
+
+        // Stable, so the first of several children with the same ID is still the one found
+        std::stable_sort(rIndex.begin(), rIndex.end(), [](const SChildEntry& rkA, const SChildEntry& rkB) {
+            return rkA.ID < rkB.ID;
+        });
+    }
+
 public:
     // Interface
     uint32_t ReadSize()
@@ -86,6 +132,11 @@ public:
     }
 
     bool ParamBegin(const char* pkName, uint32_t Flags) override
+    {
+        return ParamBeginHashed(pkName, CCRC32::StaticHashString(pkName), Flags);
+    }
+
+    bool ParamBeginHashed(const char* /*pkName*/, uint32_t ParamID, uint32_t Flags) override
     {
         // If this is the parent parameter's first child, then read the child count
         if (mBinaryParmStack.back().NumChildren == 0xFFFFFFFF)
@@ -95,7 +146,6 @@ public:
 
         // Save current offset
         const auto Offset = mpStream->Tell();
-        const auto ParamID = TString(pkName).Hash32();
 
         // Check the next parameter ID first and check whether it's a match for the current parameter
         if (mBinaryParmStack.back().ChildIndex < mBinaryParmStack.back().NumChildren)
@@ -106,34 +156,32 @@ public:
             // Does the next parameter ID match the current one?
             if (NextID == ParamID || (Flags & SH_IgnoreName))
             {
-                mBinaryParmStack.push_back( SBinaryParm { mpStream->Tell(), NextSize, 0xFFFFFFFF, 0 } );
+                mBinaryParmStack.push_back( SBinaryParm { mpStream->Tell(), NextSize, 0xFFFFFFFF, 0, false } );
                 return true;
             }
         }
 
-        // It's not a match - return to the parent parameter's first child and check all children to find a match
-        if (!mBinaryParmStack.empty())
+        // It's not a match - look it up among all of the parent's children instead. The index is built
+        // on the first miss and reused for the rest of the parent, so each miss after that is a search.
+        const size_t Depth = mBinaryParmStack.size() - 1;
+
+        if (!mBinaryParmStack.back().HasChildIndex)
         {
-            const auto ParentOffset = mBinaryParmStack.back().Offset;
-            const auto NumChildren = mBinaryParmStack.back().NumChildren;
-            mpStream->GoTo(ParentOffset);
+            BuildChildIndex(Depth);
+            mBinaryParmStack.back().HasChildIndex = true;
+        }
 
-            for (uint32_t ChildIdx = 0; ChildIdx < NumChildren; ChildIdx++)
-            {
-                const auto ChildID = mpStream->ReadU32();
-                const auto ChildSize = ReadSize();
-
-                if (ChildID != ParamID)
-                {
-                    mpStream->Skip(ChildSize);
-                }
-                else
-                {
-                    mBinaryParmStack.back().ChildIndex = ChildIdx;
-                    mBinaryParmStack.push_back(SBinaryParm{mpStream->Tell(), ChildSize, 0xFFFFFFFF, 0});
-                    return true;
-                }
-            }
+        const std::vector<SChildEntry>& rkIndex = mChildIndices[Depth];
+        const auto Iter = std::lower_bound(rkIndex.begin(), rkIndex.end(), ParamID, [](const SChildEntry& rkEntry, uint32_t ID) {
+            return rkEntry.ID < ID;
+        });
+
+        if (Iter != rkIndex.end() && Iter->ID == ParamID)
+        {
+            mBinaryParmStack.back().ChildIndex = Iter->ChildIndex;
+            mpStream->GoTo(Iter->Offset);
+            mBinaryParmStack.push_back(SBinaryParm{Iter->Offset, Iter->Size, 0xFFFFFFFF, 0, false});
+            return true;
         }
 
         // None of the children were a match - this parameter isn't in the file
@@ -190,6 +238,7 @@ public:
     void SerializePrimitive(CFourCC& rValue, uint32_t Flags) override  { rValue = CFourCC(*mpStream); }
     void SerializePrimitive(CAssetID& rValue, uint32_t Flags) override { rValue = CAssetID(*mpStream, Game()); }
     void SerializeBulkData(void* pData, uint32_t Size, uint32_t Flags) override { mpStream->ReadBytes(pData, Size); }
+    void SerializeBulkArray(void* pData, size_t Count, uint32_t ComponentSize, uint32_t Flags) override { mpStream->ReadArray(pData, Count, ComponentSize); }
 };
 
 #endif // AXIO_CBINARYREADER_H
@@ -9,7 +9,7 @@ class CBinaryWriter : public IArchive
 {
     struct SParameter
     {
-        uint32_t Offset;
+        uint64_t Offset;
         uint32_t NumSubParams;
     };
     std::vector<SParameter> mParamStack;
@@ -24,7 +24,7 @@ public:
         , mOwnsStream(true)
     {
         mArchiveFlags = AF_Writer | AF_Binary;
-        mpStream = new CFileOutStream(rkFilename, std::endian::big);
+        mpStream = new CFileOutStream(rkFilename, std::endian::big, CFileOutStream::skDefaultBufferSize);
 
         if (mpStream->IsValid())
         {
@@ -68,8 +68,7 @@ public:
         // Write magic and delete stream
         if (mOwnsStream)
         {
-            mpStream->GoTo(0);
-            mpStream->WriteU32(mMagic);
+            mpStream->PatchU32(0, mMagic);
             delete mpStream;
         }
     }
@@ -88,6 +87,11 @@ private:
 public:
     // Interface
     bool ParamBegin(const char* pkName, uint32_t Flags) override
+    {
+        return ParamBeginHashed(pkName, CCRC32::StaticHashString(pkName), Flags);
+    }
+
+    bool ParamBeginHashed(const char* /*pkName*/, uint32_t ParamID, uint32_t Flags) override
     {
         // Update parent param
         mParamStack.back().NumSubParams++;
@@ -96,7 +100,6 @@ public:
             mpStream->WriteS32(-1); // Sub-param count filler
 
         // Write param metadata
-        uint32_t ParamID = TString(pkName).Hash32();
         mpStream->WriteU32(ParamID);
         mpStream->WriteS32(-1); // Param size filler
 
@@ -110,20 +113,18 @@ public:
     {
         // Write param size
         SParameter& rParam = mParamStack.back();
-        uint32_t StartOffset = rParam.Offset;
-        uint32_t EndOffset = mpStream->Tell();
-        uint32_t ParamSize = (EndOffset - StartOffset);
+        uint64_t StartOffset = rParam.Offset;
+        uint64_t EndOffset = mpStream->Tell();
+        const auto ParamSize = static_cast<uint32_t>(EndOffset - StartOffset);
 
-        mpStream->GoTo(StartOffset - 4);
-        mpStream->WriteU32(ParamSize);
+        mpStream->PatchU32(StartOffset - 4, ParamSize);
 
         // Write param child count
         if (rParam.NumSubParams > 0 || mParamStack.size() == 1)
         {
-            mpStream->WriteU32(rParam.NumSubParams);
+            mpStream->PatchU32(StartOffset, rParam.NumSubParams);
         }
 
-        mpStream->GoTo(EndOffset);
         mParamStack.pop_back();
     }
 
@@ -157,6 +158,7 @@ public:
     void SerializePrimitive(CFourCC& rValue, uint32_t Flags) override  { rValue.Write(*mpStream); }
     void SerializePrimitive(CAssetID& rValue, uint32_t Flags) override { rValue.Write(*mpStream, CAssetID::GameIDLength(Game())); }
     void SerializeBulkData(void* pData, uint32_t Size, uint32_t Flags) override { mpStream->WriteBytes(pData, Size); }
+    void SerializeBulkArray(void* pData, size_t Count, uint32_t ComponentSize, uint32_t Flags) override { mpStream->WriteArray(pData, Count, ComponentSize); }
 };
 
 #endif // AXIO_CBINARYWRITER_H
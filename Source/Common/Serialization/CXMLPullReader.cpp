@@ -0,0 +1,569 @@
+#include "CXMLPullReader.h"
+
+#include "Common/Log.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+
+constexpr size_t skNoElement = SIZE_MAX;
+
+bool IsSpace(char Chr)
+{
+    return Chr == ' ' || Chr == '\t' || Chr == '\n' || Chr == '\r';
+}
+
+std::string_view TrimSpace(std::string_view Str)
+{
+    while (!Str.empty() && IsSpace(Str.front()))
+        Str.remove_prefix(1);
+    while (!Str.empty() && IsSpace(Str.back()))
+        Str.remove_suffix(1);
+    return Str;
+}
+
+// Accepts what TString::ToInt64 does: an optional sign, and a 0x prefix for hex. Unless Hex is set,
+// the base comes from the prefix like strtoull's base 0. Negative values wrap, as they do there.
+bool ParseInteger(std::string_view Str, bool Hex, uint64_t& rOut)
+{
+    Str = TrimSpace(Str);
+    const bool Negative = Str.starts_with('-');
+
+    if (Negative || Str.starts_with('+'))
+        Str.remove_prefix(1);
+
+    int Base = 10;
+
+    if (Str.starts_with("0x") || Str.starts_with("0X"))
+    {
+        Base = 16;
+        Str.remove_prefix(2);
+    }
+    else if (Hex)
+    {
+        Base = 16;
+    }
+    else if (Str.size() > 1 && Str.front() == '0')
+    {
+        Base = 8;
+    }
+
+    uint64_t Value = 0;
+    const auto Result = std::from_chars(Str.data(), Str.data() + Str.size(), Value, Base);
+
+    if (Str.empty() || Result.ec != std::errc() || Result.ptr != Str.data() + Str.size())
+        return false;
+
+    rOut = (Negative ? 0 - Value : Value);
+    return true;
+}
+
+void AppendUTF8(std::string& rOut, uint32_t CodePoint)
+{
+    if (CodePoint < 0x80)
+    {
+        rOut += static_cast<char>(CodePoint);
+    }
+    else if (CodePoint < 0x800)
+    {
+        rOut += static_cast<char>(0xC0 | (CodePoint >> 6));
+        rOut += static_cast<char>(0x80 | (CodePoint & 0x3F));
+    }
+    else if (CodePoint < 0x10000)
+    {
+        rOut += static_cast<char>(0xE0 | (CodePoint >> 12));
+        rOut += static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F));
+        rOut += static_cast<char>(0x80 | (CodePoint & 0x3F));
+    }
+    else
+    {
+        rOut += static_cast<char>(0xF0 | (CodePoint >> 18));
+        rOut += static_cast<char>(0x80 | ((CodePoint >> 12) & 0x3F));
+        rOut += static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F));
+        rOut += static_cast<char>(0x80 | (CodePoint & 0x3F));
+    }
+}
+
+// Replaces entity references in Raw. Returns Raw itself if there aren't any, otherwise the
+// decoded text is stored in rBuffer. Unknown entities are left as they are.
+std::string_view DecodeEntities(std::string_view Raw, std::string& rBuffer)
+{
+    size_t Amp = Raw.find('&');
+
+    if (Amp == std::string_view::npos)
+        return Raw;
+
+    rBuffer.assign(Raw.data(), Amp);
+
+    while (Amp != std::string_view::npos)
+    {
+        const size_t Semicolon = Raw.find(';', Amp);
+
+        if (Semicolon == std::string_view::npos)
+        {
+            rBuffer.append(Raw.substr(Amp));
+            break;
+        }
+
+        const std::string_view Entity = Raw.substr(Amp + 1, Semicolon - Amp - 1);
+
+        if      (Entity == "amp")   rBuffer += '&';
+        else if (Entity == "lt")    rBuffer += '<';
+        else if (Entity == "gt")    rBuffer += '>';
+        else if (Entity == "quot")  rBuffer += '"';
+        else if (Entity == "apos")  rBuffer += '\'';
+        else
+        {
+            uint32_t CodePoint = 0;
+            std::from_chars_result Result{};
+            Result.ec = std::errc::invalid_argument;
+
+            if (Entity.size() > 2 && Entity[0] == '#' && Entity[1] == 'x')
+                Result = std::from_chars(Entity.data() + 2, Entity.data() + Entity.size(), CodePoint, 16);
+            else if (Entity.size() > 1 && Entity[0] == '#')
+                Result = std::from_chars(Entity.data() + 1, Entity.data() + Entity.size(), CodePoint, 10);
+
+            if (Result.ec == std::errc() && Result.ptr == Entity.data() + Entity.size() && CodePoint <= 0x10FFFF)
+                AppendUTF8(rBuffer, CodePoint);
+            else
+                rBuffer.append(Raw.substr(Amp, Semicolon - Amp + 1));
+        }
+
+        Amp = Raw.find('&', Semicolon + 1);
+        rBuffer.append(Raw.substr(Semicolon + 1, (Amp == std::string_view::npos ? Raw.size() : Amp) - Semicolon - 1));
+    }
+
+    return rBuffer;
+}
+
+}
+
+CXMLPullReader::CXMLPullReader(const TString& rkFileName)
+    : mpMappedFile(std::make_unique<CMappedFileInStream>(rkFileName, std::endian::little))
+{
+    mArchiveFlags = AF_Reader | AF_Text;
+
+    if (!mpMappedFile->IsValid())
+    {
+        NLog::Error("{}: Failed to open XML for read", rkFileName);
+        return;
+    }
+
+    mpMappedFile->SetAccessHint(EFileAccessHint::Sequential);
+    mpkData = static_cast<const char*>(mpMappedFile->Data());
+    mDataSize = mpMappedFile->Size();
+    Init();
+}
+
+CXMLPullReader::CXMLPullReader(const void *pkData, size_t DataSize)
+    : mpkData(static_cast<const char*>(pkData))
+    , mDataSize(DataSize)
+{
+    mArchiveFlags = AF_Reader | AF_Text;
+    Init();
+}
+
+CXMLPullReader::~CXMLPullReader() = default;
+
+void CXMLPullReader::Init()
+{
+    mElemStack.reserve(16);
+
+    // Skip the declaration and anything else ahead of the root element
+    const size_t RootOffset = (mpkData ? FindNextChild(0) : skNoElement);
+    SElement Root;
+
+    if (RootOffset == skNoElement || !ParseStartTag(RootOffset, Root))
+    {
+        NLog::Error("Failed to parse XML: no root element");
+        return;
+    }
+
+    // Make sure the document isn't truncated before reading anything from it. This is a single pass
+    // over the text that doesn't allocate, and it gets the whole file paged in for the reads after.
+    if (!Root.SelfClosing && SkipToEndTag(Root.ContentStart) == skNoElement)
+    {
+        NLog::Error("Failed to parse XML: root element {} is never closed", Root.Name);
+        return;
+    }
+
+    PushElement(Root);
+    SerializeVersion();
+}
+
+bool CXMLPullReader::ParamBegin(const char *pkName, uint32_t Flags)
+{
+    return ParamBeginHashed(pkName, CCRC32::StaticHashString(pkName), Flags);
+}
+
+bool CXMLPullReader::ParamBeginHashed(const char *pkName, uint32_t NameHash, uint32_t Flags)
+{
+    ASSERT(IsValid());
+    ASSERT(!mInAttribute); // Attributes cannot have sub-children
+
+    SElement& rParent = mElemStack[mDepth - 1];
+
+    // Attributes are looked up in the current element's start tag
+    if (Flags & SH_Attribute)
+    {
+        mAttribValue = FindAttribute(rParent, pkName, mInAttribute);
+        return mInAttribute;
+    }
+
+    if (rParent.SelfClosing)
+        return false;
+
+    // Check the next element first. This is the common case when reading a file in the same order it was written.
+    const std::string_view Name(pkName);
+    const size_t NextOffset = FindNextChild(rParent.NextChild);
+    SElement Child;
+
+    if (NextOffset != skNoElement && ParseStartTag(NextOffset, Child) && ((Flags & SH_IgnoreName) || Child.Name == Name))
+    {
+        rParent.NextChild = NextOffset;
+        PushElement(Child);
+        return true;
+    }
+
+    // It's not a match - look it up among all of the parent's children instead. The index is built
+    // on the first miss and reused for the rest of the parent, so each miss after that is a search.
+    const size_t Depth = mDepth - 1;
+
+    if (!rParent.HasChildIndex)
+    {
+        BuildChildIndex(Depth);
+        rParent.HasChildIndex = true;
+    }
+
+    const std::vector<SChildEntry>& rkIndex = mChildIndices[Depth];
+    auto Iter = std::lower_bound(rkIndex.begin(), rkIndex.end(), NameHash, [](const SChildEntry& rkEntry, uint32_t Hash) {
+        return rkEntry.NameHash < Hash;
+    });
+
+    for (; Iter != rkIndex.end() && Iter->NameHash == NameHash; ++Iter)
+    {
+        if (ParseStartTag(Iter->Offset, Child) && Child.Name == Name)
+        {
+            rParent.NextChild = Iter->Offset;
+            PushElement(Child);
+            return true;
+        }
+    }
+
+    // None of the children were a match - this parameter isn't in the file
+    return false;
+}
+
+void CXMLPullReader::ParamEnd()
+{
+    if (mInAttribute)
+    {
+        mInAttribute = false;
+        return;
+    }
+
+    // Move the parent past this element, skipping over anything inside it that wasn't read
+    ASSERT(mDepth > 1);
+    const SElement& rkElem = mElemStack[--mDepth];
+    mElemStack[mDepth - 1].NextChild = (rkElem.SelfClosing ? rkElem.ContentStart : SkipToEndTag(rkElem.NextChild));
+}
+
+void CXMLPullReader::SerializeArraySize(uint32_t& Value)
+{
+    Value = 0;
+    const SElement& rkElem = mElemStack[mDepth - 1];
+
+    if (rkElem.SelfClosing)
+        return;
+
+    size_t Offset = rkElem.ContentStart;
+    SElement Child;
+
+    while ((Offset = FindNextChild(Offset)) != skNoElement && ParseStartTag(Offset, Child))
+    {
+        Value++;
+        Offset = (Child.SelfClosing ? Child.ContentStart : SkipToEndTag(Child.ContentStart));
+    }
+}
+
+bool CXMLPullReader::PreSerializePointer(void*& InPointer, uint32_t Flags)
+{
+    return ReadParam() != "NULL";
+}
+
+void CXMLPullReader::SerializeBulkData(void* pData, uint32_t Size, uint32_t Flags)
+{
+    auto* pBytes = static_cast<uint8_t*>(pData);
+    const std::string_view StringData = ReadParam();
+    ASSERT(StringData.size() == Size*2);
+
+    const auto HexValue = [](char Chr) -> uint8_t {
+        if (Chr >= '0' && Chr <= '9') return Chr - '0';
+        if (Chr >= 'A' && Chr <= 'F') return Chr - 'A' + 10;
+        if (Chr >= 'a' && Chr <= 'f') return Chr - 'a' + 10;
+        return 0;
+    };
+
+    for (size_t ByteIdx = 0; ByteIdx < Size && ByteIdx * 2 + 1 < StringData.size(); ByteIdx++)
+        pBytes[ByteIdx] = static_cast<uint8_t>((HexValue(StringData[ByteIdx * 2]) << 4) | HexValue(StringData[ByteIdx * 2 + 1]));
+}
+
+uint64_t CXMLPullReader::ReadInteger(uint32_t Flags)
+{
+    const std::string_view Str = ReadParam();
+    uint64_t Value = 0;
+
+    if (!ParseInteger(Str, (Flags & SH_HexDisplay) != 0, Value))
+        NLog::Error("Invalid integer value in XML: \"{}\"", Str);
+
+    return Value;
+}
+
+float CXMLPullReader::ReadFloat()
+{
+    std::string_view Str = TrimSpace(ReadParam());
+
+    if (Str.starts_with('+'))
+        Str.remove_prefix(1);
+
+    // Like strtof, anything unparseable reads as 0
+    float Value = 0.0f;
+    std::from_chars(Str.data(), Str.data() + Str.size(), Value);
+    return Value;
+}
+
+// ************ PRIVATE ************
+bool CXMLPullReader::ParseStartTag(size_t Offset, SElement& rOut) const
+{
+    size_t Pos = Offset + 1;
+    size_t NameEnd = Pos;
+
+    while (NameEnd < mDataSize && !IsSpace(mpkData[NameEnd]) && mpkData[NameEnd] != '/' && mpkData[NameEnd] != '>')
+        NameEnd++;
+
+    if (NameEnd == Pos)
+        return false;
+
+    // Find the end of the tag, skipping over quoted attribute values
+    for (Pos = NameEnd; Pos < mDataSize && mpkData[Pos] != '>'; Pos++)
+    {
+        if (mpkData[Pos] == '"' || mpkData[Pos] == '\'')
+        {
+            const void *pkQuote = std::memchr(&mpkData[Pos + 1], mpkData[Pos], mDataSize - Pos - 1);
+
+            if (!pkQuote)
+                return false;
+
+            Pos = static_cast<const char*>(pkQuote) - mpkData;
+        }
+    }
+
+    if (Pos >= mDataSize)
+        return false;
+
+    rOut.Name = std::string_view(&mpkData[Offset + 1], NameEnd - Offset - 1);
+    rOut.SelfClosing = (Pos > NameEnd && mpkData[Pos - 1] == '/');
+    rOut.AttribStart = NameEnd;
+    rOut.AttribEnd = (rOut.SelfClosing ? Pos - 1 : Pos);
+    rOut.ContentStart = Pos + 1;
+    rOut.NextChild = rOut.ContentStart;
+    rOut.HasChildIndex = false;
+    return true;
+}
+
+size_t CXMLPullReader::FindNextChild(size_t Offset) const
+{
+    while (Offset < mDataSize)
+    {
+        const void *pkTag = std::memchr(&mpkData[Offset], '<', mDataSize - Offset);
+
+        if (!pkTag)
+            break;
+
+        Offset = static_cast<const char*>(pkTag) - mpkData;
+
+        if (Offset + 1 >= mDataSize || mpkData[Offset + 1] == '/')
+            break;
+
+        if (mpkData[Offset + 1] == '!' || mpkData[Offset + 1] == '?')
+            Offset = SkipMarkup(Offset);
+        else
+            return Offset;
+    }
+
+    return skNoElement;
+}
+
+size_t CXMLPullReader::SkipToEndTag(size_t Offset) const
+{
+    size_t Depth = 0;
+
+    while (Offset < mDataSize)
+    {
+        const void *pkTag = std::memchr(&mpkData[Offset], '<', mDataSize - Offset);
+
+        if (!pkTag || static_cast<const char*>(pkTag) + 1 == &mpkData[mDataSize])
+            break;
+
+        Offset = static_cast<const char*>(pkTag) - mpkData;
+        const char Next = mpkData[Offset + 1];
+
+        if (Next == '/')
+        {
+            const void *pkEnd = std::memchr(&mpkData[Offset], '>', mDataSize - Offset);
+
+            if (!pkEnd)
+                break;
+
+            Offset = static_cast<const char*>(pkEnd) - mpkData + 1;
+
+            if (Depth == 0)
+                return Offset;
+
+            Depth--;
+        }
+        else if (Next == '!' || Next == '?')
+        {
+            Offset = SkipMarkup(Offset);
+        }
+        else
+        {
+            SElement Child;
+
+            if (!ParseStartTag(Offset, Child))
+                break;
+
+            if (!Child.SelfClosing)
+                Depth++;
+
+            Offset = Child.ContentStart;
+        }
+    }
+
+    return skNoElement;
+}
+
+size_t CXMLPullReader::SkipMarkup(size_t Offset) const
+{
+    const std::string_view Data(mpkData, mDataSize);
+    const std::string_view Markup = Data.substr(Offset);
+    std::string_view Terminator;
+
+    if (Markup.starts_with("<!--"))
+        Terminator = "-->";
+    else if (Markup.starts_with("<![CDATA["))
+        Terminator = "]]>";
+    else if (Markup.starts_with("<?"))
+        Terminator = "?>";
+    else
+    {
+        // DOCTYPE and friends; an internal subset in brackets may contain '>'
+        const size_t Bracket = Data.find_first_of("[>", Offset);
+        size_t End = (Bracket != std::string_view::npos && Data[Bracket] == '[' ? Data.find(']', Bracket) : Bracket);
+        End = (End != std::string_view::npos ? Data.find('>', End) : End);
+        return (End != std::string_view::npos ? End + 1 : mDataSize);
+    }
+
+    const size_t End = Data.find(Terminator, Offset + 2);
+    return (End != std::string_view::npos ? End + Terminator.size() : mDataSize);
+}
+
+void CXMLPullReader::PushElement(const SElement& rkElem)
+{
+    if (mDepth == mElemStack.size())
+        mElemStack.push_back(rkElem);
+    else
+        mElemStack[mDepth] = rkElem;
+
+    mDepth++;
+}
+
+void CXMLPullReader::BuildChildIndex(size_t Depth)
+{
+    if (mChildIndices.size() <= Depth)
+        mChildIndices.resize(Depth + 1);
+
+    std::vector<SChildEntry>& rIndex = mChildIndices[Depth];
+    rIndex.clear();
+
+    size_t Offset = mElemStack[Depth].ContentStart;
+    SElement Child;
+
+    while ((Offset = FindNextChild(Offset)) != skNoElement && ParseStartTag(Offset, Child))
+    {
+        rIndex.push_back(SChildEntry{CCRC32::StaticHashString(Child.Name), Offset});
+        Offset = (Child.SelfClosing ? Child.ContentStart : SkipToEndTag(Child.ContentStart));
+    }
+
+    // Stable, so the first of several children with the same name is still the one found
+    std::stable_sort(rIndex.begin(), rIndex.end(), [](const SChildEntry& rkA, const SChildEntry& rkB) {
+        return rkA.NameHash < rkB.NameHash;
+    });
+}
+
+std::string_view CXMLPullReader::FindAttribute(const SElement& rkElem, std::string_view Name, bool& rFound) const
+{
+    size_t Pos = rkElem.AttribStart;
+    const size_t End = rkElem.AttribEnd;
+
+    while (Pos < End)
+    {
+        while (Pos < End && IsSpace(mpkData[Pos]))
+            Pos++;
+
+        const size_t NameStart = Pos;
+
+        while (Pos < End && !IsSpace(mpkData[Pos]) && mpkData[Pos] != '=')
+            Pos++;
+
+        const std::string_view AttribName(&mpkData[NameStart], Pos - NameStart);
+
+        while (Pos < End && mpkData[Pos] != '"' && mpkData[Pos] != '\'')
+            Pos++;
+
+        if (Pos >= End)
+            break;
+
+        const char Quote = mpkData[Pos];
+        const size_t ValueStart = ++Pos;
+
+        while (Pos < End && mpkData[Pos] != Quote)
+            Pos++;
+
+        if (AttribName == Name)
+        {
+            rFound = true;
+            return std::string_view(&mpkData[ValueStart], Pos - ValueStart);
+        }
+
+        Pos++;
+    }
+
+    rFound = false;
+    return {};
+}
+
+std::string_view CXMLPullReader::ReadParam()
+{
+    if (mInAttribute)
+        return DecodeEntities(mAttribValue, mDecodeBuffer);
+
+    // Element text runs up to the first tag inside it
+    const SElement& rkElem = mElemStack[mDepth - 1];
+
+    if (rkElem.SelfClosing)
+        return {};
+
+    const std::string_view Content(&mpkData[rkElem.ContentStart], mDataSize - rkElem.ContentStart);
+
+    if (Content.starts_with("<![CDATA["))
+    {
+        const size_t End = Content.find("]]>");
+        return Content.substr(9, End == std::string_view::npos ? std::string_view::npos : End - 9);
+    }
+
+    return DecodeEntities(Content.substr(0, Content.find('<')), mDecodeBuffer);
+}
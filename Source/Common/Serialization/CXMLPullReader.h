@@ -0,0 +1,107 @@
+#ifndef AXIO_CXMLPULLREADER_H
+#define AXIO_CXMLPULLREADER_H
+
+#include "Common/CFourCC.h"
+#include "Common/FileIO/CMappedFileInStream.h"
+#include "Common/Serialization/IArchive.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// XML reader that parses straight out of a memory-mapped file (or a caller-provided buffer)
+// instead of loading the document into a tinyxml2 DOM. Parameters are located by walking forward
+// through the text, so reading them in the order they were written doesn't allocate. When a
+// parameter is requested out of order, the children of its parent are indexed by name hash once
+// and every later lookup under that parent is a search of that index.
+// Reads the same files as CXMLReader. Comments, processing instructions and DTDs are skipped;
+// CDATA is only understood as the whole value of an element.
+class CXMLPullReader : public IArchive
+{
+    struct SElement
+    {
+        std::string_view Name;
+        size_t AttribStart;     // Attribute text inside the start tag
+        size_t AttribEnd;
+        size_t ContentStart;    // Just past the start tag
+        size_t NextChild;       // Where to look for the next child element
+        bool SelfClosing;
+        bool HasChildIndex;
+    };
+    std::vector<SElement> mElemStack;   // Grows to the deepest nesting level and is reused after that
+    size_t mDepth = 0;
+
+    // Children of an element sorted by name hash, built the first time a child is requested out of
+    // order. Indexed by depth; the vectors are kept around so later elements can reuse their storage.
+    struct SChildEntry
+    {
+        uint32_t NameHash;
+        size_t Offset;
+    };
+    std::vector<std::vector<SChildEntry>> mChildIndices;
+
+    std::unique_ptr<CMappedFileInStream> mpMappedFile;
+    const char *mpkData = nullptr;
+    size_t mDataSize = 0;
+
+    std::string_view mAttribValue;      // Value of the attribute being read
+    bool mInAttribute = false;
+    std::string mDecodeBuffer;          // Holds values that contained entity references
+
+public:
+    explicit CXMLPullReader(const TString& rkFileName);
+    CXMLPullReader(const void *pkData, size_t DataSize);
+    ~CXMLPullReader() override;
+
+    bool IsValid() const
+    {
+        return mDepth > 0;
+    }
+
+    // Interface
+    bool ParamBegin(const char *pkName, uint32_t Flags) override;
+    bool ParamBeginHashed(const char *pkName, uint32_t NameHash, uint32_t Flags) override;
+    void ParamEnd() override;
+
+private:
+    void Init();
+    bool ParseStartTag(size_t Offset, SElement& rOut) const;
+    size_t FindNextChild(size_t Offset) const;
+    size_t SkipToEndTag(size_t Offset) const;
+    size_t SkipMarkup(size_t Offset) const;
+    void PushElement(const SElement& rkElem);
+    void BuildChildIndex(size_t Depth);
+    std::string_view FindAttribute(const SElement& rkElem, std::string_view Name, bool& rFound) const;
+
+protected:
+    std::string_view ReadParam();
+    uint64_t ReadInteger(uint32_t Flags);
+    float ReadFloat();
+
+public:
+    void SerializeArraySize(uint32_t& Value) override;
+    bool PreSerializePointer(void*& InPointer, uint32_t Flags) override;
+
+    void SerializePrimitive(bool& rValue, uint32_t Flags)  override    { rValue = ReadParam() == "true"; }
+    void SerializePrimitive(char& rValue, uint32_t Flags) override     { const auto Value = ReadParam(); rValue = Value.empty() ? '\0' : Value.front(); }
+    void SerializePrimitive(int8_t& rValue, uint32_t Flags) override   { rValue = (int8_t)ReadInteger(Flags); }
+    void SerializePrimitive(uint8_t& rValue, uint32_t Flags) override  { rValue = (uint8_t)ReadInteger(Flags); }
+    void SerializePrimitive(int16_t& rValue, uint32_t Flags) override  { rValue = (int16_t)ReadInteger(Flags); }
+    void SerializePrimitive(uint16_t& rValue, uint32_t Flags) override { rValue = (uint16_t)ReadInteger(Flags); }
+    void SerializePrimitive(int32_t& rValue, uint32_t Flags) override  { rValue = (int32_t)ReadInteger(Flags); }
+    void SerializePrimitive(uint32_t& rValue, uint32_t Flags) override { rValue = (uint32_t)ReadInteger(Flags); }
+    void SerializePrimitive(int64_t& rValue, uint32_t Flags) override  { rValue = (int64_t)ReadInteger(Flags); }
+    void SerializePrimitive(uint64_t& rValue, uint32_t Flags) override { rValue = (uint64_t)ReadInteger(Flags); }
+    void SerializePrimitive(float& rValue, uint32_t Flags) override    { rValue = ReadFloat(); }
+    void SerializePrimitive(double& rValue, uint32_t Flags) override   { rValue = (double)ReadFloat(); }
+    void SerializePrimitive(TString& rValue, uint32_t Flags) override  { rValue = ReadString(); }
+    void SerializePrimitive(CFourCC& rValue, uint32_t Flags) override  { rValue = CFourCC(ReadString()); }
+    void SerializePrimitive(CAssetID& rValue, uint32_t Flags) override { rValue = CAssetID::FromString(ReadString()); }
+    void SerializeBulkData(void* pData, uint32_t Size, uint32_t Flags) override;
+
+private:
+    TString ReadString() { return TString(std::string(ReadParam())); }
+};
+
+#endif // AXIO_CXMLPULLREADER_H
@@ -0,0 +1,367 @@
+#ifndef AXIO_CXMLSTREAMWRITER_H
+#define AXIO_CXMLSTREAMWRITER_H
+
+#include "Common/CFourCC.h"
+#include "Common/Log.h"
+#include "Common/FileIO/CFileOutStream.h"
+#include "Common/Serialization/IArchive.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <string_view>
+#include <vector>
+
+// XML writer that emits the document to a stream as parameters are serialized, instead of building
+// a tinyxml2 DOM and saving it at the end. Memory use only depends on how deeply parameters are
+// nested. The output matches CXMLWriter and can be read back with CXMLReader.
+//
+// Since nothing is ever revisited, attributes have to be serialized before any child parameters
+// or text of the element they belong to. Start tags are held back until something is written
+// inside them, so empty parameters are dropped just like in CXMLWriter.
+class CXMLStreamWriter : public IArchive
+{
+    struct SElement
+    {
+        TString Name;
+        bool HasChildren = false;
+    };
+    std::vector<SElement> mElemStack;   // Grows to the deepest nesting level and is reused after that
+    size_t mDepth = 0;                  // Number of elements currently open
+    size_t mNumWritten = 0;             // Number of open elements whose start tag has been written
+    bool mTagOpen = false;              // The last start tag written can still take attributes
+
+    IOutputStream *mpStream = nullptr;
+    const char* mpAttributeName = nullptr;
+    bool mOwnsStream = false;
+    bool mSaved = false;
+
+public:
+    explicit CXMLStreamWriter(const TString& rkFileName, const TString& rkRootName, uint16_t FileVersion = 0, EGame Game = EGame::Invalid)
+        : mOwnsStream(true)
+    {
+        mpStream = new CFileOutStream(rkFileName, std::endian::little, CFileOutStream::skDefaultBufferSize);
+
+        if (!mpStream->IsValid())
+            NLog::Error("Failed to open XML file for write: {}", rkFileName);
+
+        Init(rkRootName, FileVersion, Game);
+    }
+
+    explicit CXMLStreamWriter(IOutputStream *pStream, const TString& rkRootName, uint16_t FileVersion = 0, EGame Game = EGame::Invalid)
+        : mpStream(pStream)
+    {
+        ASSERT(pStream && pStream->IsValid());
+        Init(rkRootName, FileVersion, Game);
+    }
+
+    ~CXMLStreamWriter() override
+    {
+        if (!mSaved)
+        {
+            [[maybe_unused]] bool SaveSuccess = Save();
+            ASSERT(SaveSuccess);
+        }
+
+        if (mOwnsStream)
+            delete mpStream;
+    }
+
+    /**
+     * Closes the root element. Nothing can be written after this. If the writer opened the file
+     * itself, the file is closed here too and the result reflects whether all data was written.
+     * A stream passed in by the caller is left open; the caller must flush it and check for errors.
+     */
+    bool Save()
+    {
+        if (mSaved)
+        {
+            NLog::Error("Attempted to save XML twice!");
+            return false;
+        }
+
+        ASSERT(mDepth == 1 && !mpAttributeName);
+        EndElement();
+        Write("\n");
+        mSaved = true;
+
+        const bool Success = (mOwnsStream ? static_cast<CFileOutStream*>(mpStream)->Close() : mpStream->IsValid());
+
+        if (!Success)
+        {
+            NLog::Error("Failed to write XML output");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool IsValid() const
+    {
+        return mpStream->IsValid() && !mSaved;
+    }
+
+    // Interface
+    bool ParamBegin(const char *pkName, uint32_t Flags) override
+    {
+        ASSERT(IsValid());
+        ASSERT(!mpAttributeName); // Attributes cannot have sub-children
+
+        if (Flags & SH_Attribute)
+            mpAttributeName = pkName;
+        else
+            BeginElement(pkName);
+
+        return true;
+    }
+
+    void ParamEnd() override
+    {
+        if (mpAttributeName)
+            mpAttributeName = nullptr;
+        else
+            EndElement();
+    }
+
+private:
+    void Init(const TString& rkRootName, uint16_t FileVersion, EGame Game)
+    {
+        mArchiveFlags = AF_Writer | AF_Text;
+        SetVersion(skCurrentArchiveVersion, FileVersion, Game);
+        mElemStack.reserve(16);
+
+        // Write declaration; the root element is always written, even if it ends up empty
+        Write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+        BeginElement(rkRootName.CString());
+        WriteStartTags();
+
+        // Write version data
+        SerializeVersion();
+    }
+
+    void Write(std::string_view Str)
+    {
+        mpStream->WriteBytes(Str.data(), Str.size());
+    }
+
+    void WriteIndent(size_t Depth)
+    {
+        static constexpr std::string_view skSpaces = "                                ";
+        size_t NumSpaces = Depth * 4;
+
+        while (NumSpaces > 0)
+        {
+            const size_t Count = std::min(NumSpaces, skSpaces.size());
+            Write(skSpaces.substr(0, Count));
+            NumSpaces -= Count;
+        }
+    }
+
+    // Writes Str with markup characters replaced by entities
+    void WriteEscaped(std::string_view Str)
+    {
+        size_t RunStart = 0;
+
+        for (size_t ChrIdx = 0; ChrIdx < Str.size(); ChrIdx++)
+        {
+            std::string_view Entity;
+
+            switch (Str[ChrIdx])
+            {
+            case '&':   Entity = "&amp;";   break;
+            case '<':   Entity = "&lt;";    break;
+            case '>':   Entity = "&gt;";    break;
+            case '"':   Entity = "&quot;";  break;
+            default:    continue;
+            }
+
+            Write(Str.substr(RunStart, ChrIdx - RunStart));
+            Write(Entity);
+            RunStart = ChrIdx + 1;
+        }
+
+        Write(Str.substr(RunStart));
+    }
+
+    void BeginElement(const char *pkName)
+    {
+        if (mDepth == mElemStack.size())
+            mElemStack.emplace_back();
+
+        SElement& rElem = mElemStack[mDepth++];
+        rElem.Name = pkName;
+        rElem.HasChildren = false;
+    }
+
+    void EndElement()
+    {
+        ASSERT(mDepth > 0);
+        const size_t ElemIdx = --mDepth;
+
+        // Elements that never had anything written to them are dropped
+        if (ElemIdx >= mNumWritten)
+            return;
+
+        SElement& rElem = mElemStack[ElemIdx];
+
+        if (mTagOpen)
+        {
+            Write("/>");
+            mTagOpen = false;
+        }
+        else
+        {
+            if (rElem.HasChildren)
+            {
+                Write("\n");
+                WriteIndent(ElemIdx);
+            }
+
+            Write("</");
+            Write(rElem.Name);
+            Write(">");
+        }
+
+        mNumWritten--;
+    }
+
+    // Writes out the start tags of all open elements that haven't been written yet
+    void WriteStartTags()
+    {
+        for (; mNumWritten < mDepth; mNumWritten++)
+        {
+            if (mNumWritten > 0)
+            {
+                CloseStartTag();
+                mElemStack[mNumWritten - 1].HasChildren = true;
+            }
+
+            Write("\n");
+            WriteIndent(mNumWritten);
+            Write("<");
+            Write(mElemStack[mNumWritten].Name);
+            mTagOpen = true;
+        }
+    }
+
+    void CloseStartTag()
+    {
+        if (mTagOpen)
+        {
+            Write(">");
+            mTagOpen = false;
+        }
+    }
+
+    // Starts writing the value of the current parameter. Returns false if it can't be written.
+    bool BeginValue()
+    {
+        WriteStartTags();
+
+        if (mpAttributeName)
+        {
+            if (!mTagOpen)
+            {
+                NLog::Error("XML attribute {} was serialized after the contents of element {} and will not be saved",
+                            mpAttributeName, mElemStack[mDepth - 1].Name);
+                return false;
+            }
+
+            Write(" ");
+            Write(mpAttributeName);
+            Write("=\"");
+        }
+        else
+        {
+            CloseStartTag();
+        }
+
+        return true;
+    }
+
+    void EndValue()
+    {
+        if (mpAttributeName)
+            Write("\"");
+    }
+
+protected:
+    void WriteParam(std::string_view Value)
+    {
+        if (BeginValue())
+        {
+            WriteEscaped(Value);
+            EndValue();
+        }
+    }
+
+    template<typename IntType>
+    void WriteInteger(IntType Value, uint32_t Flags)
+    {
+        char Buffer[32];
+        const auto Result = (Flags & SH_HexDisplay) ? fmt::format_to_n(Buffer, sizeof(Buffer), "0x{:X}", Value)
+                                                    : fmt::format_to_n(Buffer, sizeof(Buffer), "{}", Value);
+        WriteParam(std::string_view(Buffer, Result.size));
+    }
+
+public:
+    bool PreSerializePointer(void*& Pointer, uint32_t Flags) override
+    {
+        if (!Pointer)
+        {
+            WriteParam("NULL");
+            return false;
+        }
+        return true;
+    }
+
+    void SerializeArraySize(uint32_t& Value) override
+    {
+        // Do nothing. Reader obtains container size from number of child elements
+    }
+
+    void SerializePrimitive(bool& rValue, uint32_t Flags) override     { WriteParam(rValue ? "true" : "false"); }
+    void SerializePrimitive(char& rValue, uint32_t Flags) override     { WriteParam(std::string_view(&rValue, 1)); }
+    void SerializePrimitive(int8_t& rValue, uint32_t Flags) override   { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(uint8_t& rValue, uint32_t Flags) override  { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(int16_t& rValue, uint32_t Flags) override  { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(uint16_t& rValue, uint32_t Flags) override { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(int32_t& rValue, uint32_t Flags) override  { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(uint32_t& rValue, uint32_t Flags) override { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(int64_t& rValue, uint32_t Flags) override  { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(uint64_t& rValue, uint32_t Flags) override { WriteInteger(rValue, Flags); }
+    void SerializePrimitive(float& rValue, uint32_t Flags) override    { WriteParam(TString::FromFloat(rValue, 1, true)); }
+    void SerializePrimitive(double& rValue, uint32_t Flags) override   { WriteParam(TString::FromFloat((float)rValue, 1, true)); }
+    void SerializePrimitive(TString& rValue, uint32_t Flags) override  { WriteParam(rValue); }
+    void SerializePrimitive(CFourCC& rValue, uint32_t Flags) override  { WriteParam(rValue.ToString()); }
+    void SerializePrimitive(CAssetID& rValue, uint32_t Flags) override { WriteParam(rValue.ToString(CAssetID::GameIDLength(Game()))); }
+
+    void SerializeBulkData(void* pData, uint32_t Size, uint32_t Flags) override
+    {
+        static constexpr char skHexDigits[] = "0123456789ABCDEF";
+
+        if (!BeginValue())
+            return;
+
+        const auto* pkBytes = static_cast<const uint8_t*>(pData);
+        char Buffer[0x400];
+
+        while (Size > 0)
+        {
+            const uint32_t Count = std::min<uint32_t>(Size, sizeof(Buffer) / 2);
+
+            for (uint32_t ByteIdx = 0; ByteIdx < Count; ByteIdx++)
+            {
+                Buffer[ByteIdx * 2]     = skHexDigits[pkBytes[ByteIdx] >> 4];
+                Buffer[ByteIdx * 2 + 1] = skHexDigits[pkBytes[ByteIdx] & 0xF];
+            }
+
+            Write(std::string_view(Buffer, Count * 2));
+            pkBytes += Count;
+            Size -= Count;
+        }
+
+        EndValue();
+    }
+};
+
+#endif // AXIO_CXMLSTREAMWRITER_H
@@ -7,6 +7,8 @@
 #include "Common/CFourCC.h"
 #include "Common/EGame.h"
 #include "Common/TString.h"
+#include "Common/FileIO/NByteSwap.h"
+#include "Common/Hash/CCRC32.h"
 
 #include <concepts>
 #include <cstdint>
@@ -90,9 +92,66 @@ template<typename>   struct TIsSmartPointer : std::false_type {};
 template<typename T> struct TIsSmartPointer<std::shared_ptr<T>> : std::true_type {};
 template<typename T> struct TIsSmartPointer<std::unique_ptr<T>> : std::true_type {};
 
+/**
+ * Class that determines the scalar type a std::vector element is made of when the vector is
+ * written to binary archives as a single block. Nothing qualifies unless it opts in, since doing
+ * so changes the file layout of every vector of that type. Trivially copyable classes opt in by
+ * declaring e.g. "using BulkSerialComponent = float;"; arithmetic types by specializing this
+ * template, e.g. "template<> struct TBulkSerialComponent<float> { using Type = float; };".
+ * The component type is what gets byteswapped, so the element must consist of nothing else.
+ */
+template<typename T>
+struct TBulkSerialComponent { using Type = void; };
+template<typename T> requires requires { typename T::BulkSerialComponent; }
+struct TBulkSerialComponent<T> { using Type = typename T::BulkSerialComponent; };
+
+template<typename T>
+constexpr inline bool TIsBulkSerializable = !std::is_void_v<typename TBulkSerialComponent<T>::Type>;
+
 /** Helper macro that tells us whether the parameter supports default property values */
 #define SUPPORTS_DEFAULT_VALUES (!std::is_pointer_v<ValType> && std::is_copy_assignable_v<ValType> && std::equality_comparable<ValType> && !TIsContainer<ValType>::value && !TIsSmartPointer<ValType>::value)
 
+/**
+ * CSerialName - parameter name along with its CRC32 hash, which is what binary archives store.
+ * Names built in a constant expression (e.g. a constexpr CSerialName) are hashed at compile time;
+ * any other name, including a const array that isn't constexpr, is hashed when it is created.
+ */
+class CSerialName
+{
+    const char* mpkName;
+    uint32_t    mHash;
+
+public:
+    template<size_t N>
+    constexpr CSerialName(const char (&rkName)[N])
+        : mpkName(rkName), mHash(0)
+    {
+        if consteval
+        {
+            mHash = CCRC32::ConstHashString(std::string_view(rkName, std::char_traits<char>::length(rkName)));
+        }
+        else
+        {
+            mHash = CCRC32::StaticHashString(rkName);
+        }
+    }
+
+    // Mutable buffers can't be hashed at compile time
+    template<size_t N>
+    CSerialName(char (&rName)[N])
+        : mpkName(rName), mHash(CCRC32::StaticHashString(rName))
+    {}
+
+    template<typename CharPtr>
+    requires(std::same_as<CharPtr, const char*> || std::same_as<CharPtr, char*>)
+    CSerialName(CharPtr pkName)
+        : mpkName(pkName), mHash(CCRC32::StaticHashString(pkName))
+    {}
+
+    constexpr const char* Name() const  { return mpkName; }
+    constexpr uint32_t Hash() const     { return mHash; }
+};
+
 /** TSerialParameter - name/value pair for generic serial parameters */
 template<typename ValType>
 struct TSerialParameter
@@ -101,20 +160,21 @@ struct TSerialParameter
     ValType&            rValue;
     uint32_t            HintFlags;
     const ValType*      pDefaultValue;
+    uint32_t            NameHash;
 };
 
 /** Function that creates a SerialParameter */
 template<typename ValType>
 std::enable_if_t<SUPPORTS_DEFAULT_VALUES, TSerialParameter<ValType>>
-inline SerialParameter(const char* pkName, ValType& rValue, uint32_t HintFlags = 0, const ValType& rkDefaultValue = ValType())
+inline SerialParameter(CSerialName Name, ValType& rValue, uint32_t HintFlags = 0, const ValType& rkDefaultValue = ValType())
 {
-    return TSerialParameter<ValType> { pkName, rValue, HintFlags, &rkDefaultValue };
+    return TSerialParameter<ValType> { Name.Name(), rValue, HintFlags, &rkDefaultValue, Name.Hash() };
 }
 template<typename ValType>
 std::enable_if_t<!SUPPORTS_DEFAULT_VALUES, TSerialParameter<ValType>>
-inline SerialParameter(const char* pkName, ValType& rValue, uint32_t HintFlags = 0)
+inline SerialParameter(CSerialName Name, ValType& rValue, uint32_t HintFlags = 0)
 {
-    return TSerialParameter<ValType> { pkName, rValue, HintFlags, nullptr };
+    return TSerialParameter<ValType> { Name.Name(), rValue, HintFlags, nullptr, Name.Hash() };
 }
 
 /** Returns whether the parameter value matches its default value */
@@ -281,6 +341,7 @@ public:
         eArVer_Refactor,
         eArVer_MapAttributes,
         eArVer_GameEnumClass,
+        eArVer_BulkVectors,
         // Insert new versions before this line
         eArVer_Max
     };
@@ -316,7 +377,7 @@ private:
     bool InternalStartParam(const TSerialParameter<ValType>& Param)
     {
         bool IsProxy = (Param.HintFlags & SH_Proxy) != 0;
-        return ShouldSerializeParameter(Param) && (IsProxy || ParamBegin(Param.pkName, Param.HintFlags) );
+        return ShouldSerializeParameter(Param) && (IsProxy || ParamBeginHashed(Param.pkName, Param.NameHash, Param.HintFlags) );
     }
 
     // Ends a parameter.
@@ -670,6 +731,17 @@ public:
 
     // Interface
     virtual bool ParamBegin(const char *pkName, uint32_t Flags) = 0;
+
+    // Same as ParamBegin, with the CRC32 of the name already worked out. Archives that identify
+    // parameters by hash override this to avoid rehashing the name on every parameter.
+    virtual bool ParamBeginHashed(const char *pkName, uint32_t /*NameHash*/, uint32_t Flags)
+    {
+        return ParamBegin(pkName, Flags);
+    }
+    bool ParamBeginHashed(CSerialName Name, uint32_t Flags)
+    {
+        return ParamBeginHashed(Name.Name(), Name.Hash(), Flags);
+    }
     virtual void ParamEnd() = 0;
 
     virtual bool PreSerializePointer(void*& Pointer, uint32_t Flags) = 0;
@@ -690,6 +762,13 @@ public:
     virtual void SerializePrimitive(CAssetID& rValue, uint32_t Flags) = 0;
     virtual void SerializeBulkData(void* pData, uint32_t DataSize, uint32_t Flags) = 0;
 
+    // Optional - serialize Count values of ComponentSize bytes each as one block, in the archive's
+    // byte order. Only used by binary formats. By default, the data is passed through as-is.
+    virtual void SerializeBulkArray(void* pData, size_t Count, uint32_t ComponentSize, uint32_t Flags)
+    {
+        SerializeBulkData(pData, static_cast<uint32_t>(Count * ComponentSize), Flags);
+    }
+
     // Optional - serialize in an array size. By default, just stores size as an attribute property.
     virtual void SerializeArraySize(uint32_t& Value)
     {
@@ -791,6 +870,28 @@ inline void Serialize(IArchive& Arc, T& Val)
 template<typename T>
 inline void Serialize(IArchive& Arc, std::vector<T>& Vector)
 {
+    // Binary archives write vectors of opted-in types as one block instead of one parameter per element
+    if constexpr (TIsBulkSerializable<T>)
+    {
+        if (Arc.IsBinaryFormat() && Arc.ArchiveVersion() >= IArchive::eArVer_BulkVectors)
+        {
+            using Component = typename TBulkSerialComponent<T>::Type;
+            static_assert(ByteSwappable<Component> && std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(Component) == 0,
+                          "Bulk serialized types must consist only of their component type.");
+
+            uint32_t Size = Vector.size();
+            Arc << SerialParameter("Size", Size, SH_Attribute);
+
+            if (Arc.IsReader())
+            {
+                Vector.resize(Size);
+            }
+
+            Arc.SerializeBulkArray(Vector.data(), Vector.size() * (sizeof(T) / sizeof(Component)), sizeof(Component), 0);
+            return;
+        }
+    }
+
     uint32_t Size = Vector.size();
     Arc.SerializeArraySize(Size);
 
@@ -886,7 +987,7 @@ inline void SerializeMap_Internal(IArchive& Arc, MapType& Map)
             KeyType Key;
             ValType Val;
 
-            if (Arc.ParamBegin("Element", SH_IgnoreName | SH_InheritHints))
+            if (Arc.ParamBeginHashed("Element", SH_IgnoreName | SH_InheritHints))
             {
                 Arc << SerialParameter("Key", Key, Hints)
                     << SerialParameter("Value", Val, Hints);
@@ -906,7 +1007,7 @@ inline void SerializeMap_Internal(IArchive& Arc, MapType& Map)
             KeyType Key = Iter->first;
             ValType Val = Iter->second;
 
-            if (Arc.ParamBegin("Element", SH_IgnoreName | SH_InheritHints))
+            if (Arc.ParamBeginHashed("Element", SH_IgnoreName | SH_InheritHints))
             {
                 Arc << SerialParameter("Key", Key, Hints)
                     << SerialParameter("Value", Val, Hints);